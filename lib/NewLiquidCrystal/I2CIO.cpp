@@ -166,6 +166,29 @@ int I2CIO::write ( uint8_t value )
    return ( (status == 0) );
 }
 
+//
+// write
+int I2CIO::write ( const uint8_t *values, uint8_t count )
+{
+   int status = 0;
+
+   if ( _initialised && count )
+   {
+      Wire.beginTransmission ( _i2cAddr );
+      for ( uint8_t i = 0; i < count; i++ )
+      {
+         _shadow = ( values[i] & ~(_dirMask) );
+#if (ARDUINO <  100)
+         Wire.send ( _shadow );
+#else
+         Wire.write ( _shadow );
+#endif
+      }
+      status = Wire.endTransmission ();
+   }
+   return ( (status == 0) );
+}
+
 //
 // digitalRead
 uint8_t I2CIO::digitalRead ( uint8_t pin )
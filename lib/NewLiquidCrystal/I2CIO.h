@@ -31,6 +31,14 @@
 
 #define _I2CIO_VERSION "1.0.0"
 
+/*!
+ @defined 
+ @abstract   I2CIO_MAXBATCH
+ @discussion Largest number of bytes sent in a single transaction by the
+ buffered write method, limited by the Wire library transmit buffer.
+ */
+#define I2CIO_MAXBATCH 32
+
 /*!
  @class
  @abstract    I2CIO
@@ -122,6 +130,21 @@ public:
     */   
    int write ( uint8_t value );
    
+   /*!
+    @method
+    @abstract   Write a sequence of values to the device.
+    @discussion Writes count values to the device in a single I2C transaction.
+    The device latches each byte onto its port as it is received, so this
+    produces the same sequence of port states as calling write for each
+    value, without the start, address and stop overhead for every byte.
+    The values are masked the same way as with write.
+    
+    @param      values[in] values to be written to the device.
+    @param      count[in] number of values, at most I2CIO_MAXBATCH.
+    @result     1 on success, 0 otherwise
+    */   
+   int write ( const uint8_t *values, uint8_t count );
+   
    /*!
     @method
     @abstract   Writes a digital level to a particular pin.
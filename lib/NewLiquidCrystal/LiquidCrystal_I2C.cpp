@@ -254,9 +254,49 @@ void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode)
    }
 }
 
+#if (ARDUINO >= 100)
 //
-// write4bits
-void LiquidCrystal_I2C::write4bits ( uint8_t value, uint8_t mode ) 
+// write - batched data write
+size_t LiquidCrystal_I2C::write(const uint8_t *buffer, size_t size)
+{
+   uint8_t frame[I2CIO_MAXBATCH];
+   uint8_t n = 0;
+   
+   for ( size_t i = 0; i < size; i++ )
+   {
+      // Each character is two nibbles. The LCD latches a nibble on the falling
+      // edge of En, so each one is sent as the data with En HIGH and then the
+      // same data with En LOW. The En LOW byte is what ends the enable pulse
+      // and holds the data steady past the falling edge, the next nibble must
+      // not change the data lines while En is still high. Every byte takes at
+      // least 22us at 400kHz, which covers the pulse width and hold time. The
+      // ~37us the LCD needs per character is covered by the two bytes of the
+      // next character's first nibble before it is latched. Do not leave out
+      // the En LOW bytes to save bus time.
+      // ------------------------------------------------------------------------
+      if ( n > (I2CIO_MAXBATCH - 4) )
+      {
+         _i2cio.write ( frame, n );
+         n = 0;
+      }
+      uint8_t hi = mapNibble ( buffer[i] >> 4 ) | _Rs | _backlightStsMask;
+      uint8_t lo = mapNibble ( buffer[i] & 0x0F ) | _Rs | _backlightStsMask;
+      frame[n++] = hi | _En;     // En HIGH
+      frame[n++] = hi & ~_En;    // En LOW
+      frame[n++] = lo | _En;
+      frame[n++] = lo & ~_En;
+   }
+   if ( n > 0 )
+   {
+      _i2cio.write ( frame, n );
+   }
+   return size;
+}
+#endif
+
+//
+// mapNibble
+uint8_t LiquidCrystal_I2C::mapNibble ( uint8_t value )
 {
    uint8_t pinMapValue = 0;
    
@@ -270,6 +310,14 @@ void LiquidCrystal_I2C::write4bits ( uint8_t value, uint8_t mode )
       }
       value = ( value >> 1 );
    }
+   return ( pinMapValue );
+}
+
+//
+// write4bits
+void LiquidCrystal_I2C::write4bits ( uint8_t value, uint8_t mode ) 
+{
+   uint8_t pinMapValue = mapNibble ( value );
    
    // Is it a command or data
    // -----------------------
@@ -286,6 +334,9 @@ void LiquidCrystal_I2C::write4bits ( uint8_t value, uint8_t mode )
 // pulseEnable
 void LiquidCrystal_I2C::pulseEnable (uint8_t data)
 {
-   _i2cio.write (data | _En);   // En HIGH
-   _i2cio.write (data & ~_En);  // En LOW
+   uint8_t pulse[2];
+   
+   pulse[0] = data | _En;   // En HIGH
+   pulse[1] = data & ~_En;  // En LOW
+   _i2cio.write ( pulse, 2 );  // both in one transaction
 }
\ No newline at end of file
@@ -122,6 +122,26 @@ public:
     command to the LCD.
     */
    virtual void send(uint8_t value, uint8_t mode);
+   
+#if (ARDUINO >= 100)
+   /*!
+    @function
+    @abstract   Writes a string of characters to the LCD.
+    @discussion Writes size characters at the current cursor position. All
+    the expander writes needed for the characters are packed into as few I2C
+    transactions as the Wire buffer allows (8 characters per transaction)
+    instead of four transactions per character.
+    
+    This overrides the Print class method, therefore print() of strings
+    and numbers ends up here.
+    
+    @param      buffer[in] characters to write.
+    @param      size[in] number of characters.
+    @result     number of characters written.
+    */
+   virtual size_t write(const uint8_t *buffer, size_t size);
+   using LCD::write;
+#endif
 
    /*!
     @function
@@ -180,6 +200,15 @@ private:
     COMMAND == command, DATA == data.
     */
    void write4bits(uint8_t value, uint8_t mode);
+   
+   /*!
+    @method
+    @abstract   Maps a 4 bit value to the expander data pins.
+    @discussion Returns the expander word that puts the 4 bits (the least
+    significant) of value on the LCD data lines.
+    @param      value[in] Value to map
+    */
+   uint8_t mapNibble(uint8_t value);
 
    /*!
     @method
@@ -76,10 +76,13 @@ class OneWire
   public:
     OneWire( uint8_t pin);
 
+    // reset(), write(), read(), write_bit() and read_bit() are virtual
+    // so a subclass can replace the bit timing, see OneWirePin.
+
     // Perform a 1-Wire reset cycle. Returns 1 if a device responds
     // with a presence pulse.  Returns 0 if there is no device or the
     // bus is shorted or otherwise held low for more than 250uS
-    uint8_t reset(void);
+    virtual uint8_t reset(void);
 
     // Issue a 1-Wire rom select command, you do the reset first.
     void select(const uint8_t rom[8]);
@@ -91,21 +94,21 @@ class OneWire
     // the end for parasitically powered devices. You are responsible
     // for eventually depowering it by calling depower() or doing
     // another read or write.
-    void write(uint8_t v, uint8_t power = 0);
+    virtual void write(uint8_t v, uint8_t power = 0);
 
     void write_bytes(const uint8_t *buf, uint16_t count, bool power = 0);
 
     // Read a byte.
-    uint8_t read(void);
+    virtual uint8_t read(void);
 
     void read_bytes(uint8_t *buf, uint16_t count);
 
     // Write a bit. The bus is always left powered at the end, see
     // note in write() about that.
-    void write_bit(uint8_t v);
+    virtual void write_bit(uint8_t v);
 
     // Read a bit.
-    uint8_t read_bit(void);
+    virtual uint8_t read_bit(void);
 
     // Stop forcing power onto the bus. You only need to do this if
     // you used the 'power' flag to write() or used a write_bit() call
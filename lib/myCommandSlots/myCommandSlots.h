@@ -0,0 +1,302 @@
+// myCommandSlots.h
+// Received commands kept in place in a fixed set of SLOTS buffers of SIZE bytes.
+// Each port has a CommandFramer and hands every byte it receives to add(), from
+// its receive interrupt or from loop(). A byte is written straight into a free
+// slot, : starts the command again and # ends it, and the slot is then queued.
+// loop() gets the oldest queued command with next() and gives the slot back with
+// release() when it is done, so a command is never copied once it is received.
+// port() tells which port the oldest command came from, so it can be answered there.
+// A command too long for a slot, or with a byte the port could not receive properly
+// (abandon()), is dropped up to its # and counted in overruns(). One that arrives with
+// every slot in use is dropped and counted in dropped(), and its port and sequence
+// number, the digits after a leading @, are kept for busy() so the sender can be told.
+// Up to BUSYRECORDS of those wait to be collected, any more are only counted.
+
+#ifndef COMMANDSLOTS_H
+#define COMMANDSLOTS_H
+
+#include <Arduino.h>
+
+#define FRAME_OK       0
+#define FRAME_OVERRUN  1                // skipping to the # of a command too long for a slot or garbled
+#define FRAME_FULL     2                // skipping to the # of a command with no free slot
+
+#define SEQ_NONE       0xFFFF           // command without a sequence number, or with one that is not valid
+#define SEQ_DIGITS     5                // most digits in a sequence number, which must also be below SEQ_NONE
+#define BUSYRECORDS    4                // dropped commands kept for busy()
+
+// framing state of one port
+struct CommandFramer {
+  int8_t slot;                          // slot being filled, -1 for none
+  uint8_t pos;                          // next place in the slot
+  uint8_t state;
+  uint8_t port;                         // given to begin(), kept with each command
+  uint16_t seq;                         // sequence number of a command being dropped as busy
+};
+
+template<uint8_t SLOTS, uint8_t SIZE>
+class CommandSlots {
+  private:
+    static_assert(SLOTS <= 8, "CommandSlots keeps the slots in use in one byte");
+    char _slot[SLOTS][SIZE];
+    uint8_t _port[SLOTS];               // port each slot was received on
+    volatile uint8_t _used;             // bit set for each slot being filled or queued
+    volatile uint8_t _queue[SLOTS];     // queued slots, oldest first
+    volatile uint8_t _first;            // place of the oldest in _queue
+    volatile uint8_t _count;            // slots queued
+    volatile uint16_t _overruns;
+    volatile uint16_t _dropped;
+    volatile uint8_t _busyport[BUSYRECORDS];
+    volatile uint16_t _busyseq[BUSYRECORDS];
+    volatile uint8_t _busyfirst;
+    volatile uint8_t _busycount;
+    inline int8_t claim();
+    inline void skipped(CommandFramer &f, char c);
+  public:
+    CommandSlots() {
+      _used = 0;
+      _first = 0;
+      _count = 0;
+      _busyfirst = 0;
+      _busycount = 0;
+      clearcounts();
+    }
+    inline void begin(CommandFramer &f, uint8_t port);
+    void add(CommandFramer &f, char c);
+    inline void abandon(CommandFramer &f);
+    inline char *next();
+    inline void release();
+    inline uint8_t port();
+    inline bool busy(uint8_t &port, uint16_t &seq);
+    inline uint8_t count();
+    inline uint16_t overruns();
+    inline uint16_t dropped();
+    inline void clearcounts();
+};
+
+// add the digit c to the sequence number seq, SEQ_NONE once it would reach SEQ_NONE
+// used for both dropped and received commands so they agree on which tags are valid
+static inline uint16_t seqdigit(uint16_t seq, char c)
+{
+  if ( seq == SEQ_NONE )
+  {
+    return SEQ_NONE;
+  }
+  uint32_t n = (uint32_t) seq * 10 + (c - '0');
+  return (n < SEQ_NONE) ? n : SEQ_NONE;
+}
+
+// take a free slot, -1 if every slot is in use
+template<uint8_t SLOTS, uint8_t SIZE>
+inline int8_t CommandSlots<SLOTS, SIZE>::claim()
+{
+  for ( uint8_t i = 0; i < SLOTS; i++ )
+  {
+    if ( !(_used & _BV(i)) )
+    {
+      _used |= _BV(i);
+      return i;
+    }
+  }
+  return -1;
+}
+
+// a byte of a command being dropped, counted when its # comes
+// for one dropped as busy pos counts the bytes so the @ of a sequence number is seen, the
+// number ends at the first byte that is not a digit, with none or more than SEQ_DIGITS it is SEQ_NONE
+template<uint8_t SLOTS, uint8_t SIZE>
+inline void CommandSlots<SLOTS, SIZE>::skipped(CommandFramer &f, char c)
+{
+  if ( c != '#' )
+  {
+    if ( (f.state == FRAME_FULL) && (f.pos <= (SEQ_DIGITS + 1)) )
+    {
+      if ( f.pos == 0 )
+      {
+        f.seq = (c == '@') ? 0 : SEQ_NONE;
+      }
+      else if ( (c >= '0') && (c <= '9') )
+      {
+        f.seq = (f.pos > SEQ_DIGITS) ? SEQ_NONE : seqdigit(f.seq, c);
+      }
+      else
+      {
+        if ( f.pos == 1 )
+        {
+          f.seq = SEQ_NONE;             // @ with no digits
+        }
+        f.pos = SEQ_DIGITS + 1;         // past the sequence number
+      }
+      f.pos++;
+    }
+    return;
+  }
+  if ( f.state == FRAME_OVERRUN )
+  {
+    _overruns++;
+  }
+  else
+  {
+    _dropped++;
+    if ( _busycount < BUSYRECORDS )
+    {
+      uint8_t i = (_busyfirst + _busycount) % BUSYRECORDS;
+      _busyport[i] = f.port;
+      _busyseq[i] = (f.pos <= 1) ? SEQ_NONE : f.seq;   // nothing, or only the @, before the #
+      _busycount++;
+    }
+  }
+  f.state = FRAME_OK;
+  f.pos = 0;
+}
+
+template<uint8_t SLOTS, uint8_t SIZE>
+inline void CommandSlots<SLOTS, SIZE>::begin(CommandFramer &f, uint8_t port)
+{
+  f.slot = -1;
+  f.pos = 0;
+  f.state = FRAME_OK;
+  f.port = port;
+}
+
+// called with every byte a port receives, interrupts are turned off while the slots change
+template<uint8_t SLOTS, uint8_t SIZE>
+void CommandSlots<SLOTS, SIZE>::add(CommandFramer &f, char c)
+{
+  if ( c == ':' )
+  {
+    f.pos = 0;                          // start of a command, drop anything before it
+    f.state = FRAME_OK;
+    return;
+  }
+  uint8_t sreg = SREG;
+  cli();
+  if ( (f.state == FRAME_OK) && (f.slot < 0) )
+  {
+    f.slot = claim();
+    f.pos = 0;
+    if ( f.slot < 0 )
+    {
+      f.state = FRAME_FULL;
+    }
+  }
+  if ( (f.state == FRAME_OK) && (f.pos >= (SIZE - 1)) )
+  {
+    f.state = FRAME_OVERRUN;            // no room left for c and the terminating 0
+  }
+  if ( f.state != FRAME_OK )
+  {
+    skipped(f, c);
+  }
+  else
+  {
+    char *buf = _slot[f.slot];
+    buf[f.pos++] = c;
+    if ( c == '#' )
+    {
+      buf[f.pos] = 0;
+      _port[f.slot] = f.port;
+      _queue[(_first + _count) % SLOTS] = f.slot;
+      _count++;
+      f.slot = -1;
+      f.pos = 0;
+    }
+  }
+  SREG = sreg;
+}
+
+// the port lost a byte of the command being received, drop it up to its #
+template<uint8_t SLOTS, uint8_t SIZE>
+inline void CommandSlots<SLOTS, SIZE>::abandon(CommandFramer &f)
+{
+  if ( f.state == FRAME_OK )
+  {
+    f.state = FRAME_OVERRUN;
+  }
+}
+
+// the oldest queued command ending in #, NULL if there is none
+template<uint8_t SLOTS, uint8_t SIZE>
+inline char *CommandSlots<SLOTS, SIZE>::next()
+{
+  return (_count == 0) ? NULL : _slot[_queue[_first]];
+}
+
+// free the slot of the command next() returned
+template<uint8_t SLOTS, uint8_t SIZE>
+inline void CommandSlots<SLOTS, SIZE>::release()
+{
+  uint8_t sreg = SREG;
+  cli();
+  if ( _count > 0 )
+  {
+    _used &= ~_BV(_queue[_first]);
+    _first = (_first + 1) % SLOTS;
+    _count--;
+  }
+  SREG = sreg;
+}
+
+// the port and sequence number of the oldest command dropped as busy, false if there is none
+template<uint8_t SLOTS, uint8_t SIZE>
+inline bool CommandSlots<SLOTS, SIZE>::busy(uint8_t &port, uint16_t &seq)
+{
+  bool found = false;
+  uint8_t sreg = SREG;
+  cli();
+  if ( _busycount > 0 )
+  {
+    port = _busyport[_busyfirst];
+    seq = _busyseq[_busyfirst];
+    _busyfirst = (_busyfirst + 1) % BUSYRECORDS;
+    _busycount--;
+    found = true;
+  }
+  SREG = sreg;
+  return found;
+}
+
+// port of the command next() returns, only valid while there is one
+template<uint8_t SLOTS, uint8_t SIZE>
+inline uint8_t CommandSlots<SLOTS, SIZE>::port()
+{
+  return _port[_queue[_first]];
+}
+
+template<uint8_t SLOTS, uint8_t SIZE>
+inline uint8_t CommandSlots<SLOTS, SIZE>::count()
+{
+  return _count;
+}
+
+template<uint8_t SLOTS, uint8_t SIZE>
+inline uint16_t CommandSlots<SLOTS, SIZE>::overruns()
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t n = _overruns;
+  SREG = sreg;
+  return n;
+}
+
+template<uint8_t SLOTS, uint8_t SIZE>
+inline uint16_t CommandSlots<SLOTS, SIZE>::dropped()
+{
+  uint8_t sreg = SREG;
+  cli();
+  uint16_t n = _dropped;
+  SREG = sreg;
+  return n;
+}
+
+template<uint8_t SLOTS, uint8_t SIZE>
+inline void CommandSlots<SLOTS, SIZE>::clearcounts()
+{
+  uint8_t sreg = SREG;
+  cli();
+  _overruns = 0;
+  _dropped = 0;
+  SREG = sreg;
+}
+
+#endif
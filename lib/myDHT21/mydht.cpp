@@ -6,6 +6,8 @@
 //     URL: http://arduino.cc/playground/Main/DHTLib
 //
 // HISTORY:
+// 0.1.13b edge() checks each gap against a window for 0 and for 1, badframes() counts failures
+// 0.1.13a add interrupt driven start/update/collect, edge() timed from pin change interrupt
 // 0.1.13 fix negative temperature
 // 0.1.12 support DHT33 and DHT44 initial version
 // 0.1.11 renamed DHTLIB_TIMEOUT
@@ -28,6 +30,11 @@
 
 #include "mydht.h"
 
+#define DHT_IDLE     0
+#define DHT_WAKEUP   1                  // start signal, line held low by the host
+#define DHT_CAPTURE  2                  // line released, edge() is assembling the bits
+#define DHT_DONE     3                  // all edges received or timed out
+
 /////////////////////////////////////////////////////
 //
 // PUBLIC
@@ -47,7 +54,115 @@ int dht::read11(uint8_t pin)
         temperature = DHTLIB_INVALID_VALUE; // invalid value
         return rv;
     }
+    return _convert11();
+}
+
+// start a DHT11 reading, the 18ms start signal is ended by update()
+void dht::start11(uint8_t pin)
+{
+    _start(pin, DHTLIB_DHT11_WAKEUP, true);
+}
+
+// start a DHT21/22/33/44 reading
+void dht::start(uint8_t pin)
+{
+    _start(pin, DHTLIB_DHT_WAKEUP, false);
+}
+
+// move the reading along, returns true while it is in progress
+bool dht::update()
+{
+    switch (_state)
+    {
+        case DHT_WAKEUP:
+            if ((millis() - _since) > _wakeupDelay)
+            {
+                _release();
+            }
+            return true;
+        case DHT_CAPTURE:
+            if ((micros() - _since) > DHTLIB_CAPTURE_TIMEOUT)
+            {
+                _state = DHT_DONE;      // edge() stops when it sees DHT_DONE
+            }
+            return _state != DHT_DONE;
+        default:
+            return false;
+    }
+}
+
+// return values:
+// DHTLIB_OK
+// DHTLIB_ERROR_CHECKSUM
+// DHTLIB_ERROR_TIMEOUT, also when no reading was started
+// DHTLIB_ERROR_FRAME
+// DHTLIB_BUSY
+int dht::collect()
+{
+    if (update())
+    {
+        return DHTLIB_BUSY;
+    }
+    uint8_t state = _state;
+    _state = DHT_IDLE;
+    pinMode(_pin, OUTPUT);
+    digitalWrite(_pin, HIGH);
+    if (state != DHT_DONE || _edges < DHTLIB_EDGES)
+    {
+        humidity    = DHTLIB_INVALID_VALUE;
+        temperature = DHTLIB_INVALID_VALUE;
+        return DHTLIB_ERROR_TIMEOUT;
+    }
+    if (_badFrame)
+    {
+        if (_badFrames < 0xFFFF) _badFrames++;
+        humidity    = DHTLIB_INVALID_VALUE;
+        temperature = DHTLIB_INVALID_VALUE;
+        return DHTLIB_ERROR_FRAME;
+    }
+    for (uint8_t i = 0; i < 5; i++) bits[i] = _rx[i];
+    return _dht11 ? _convert11() : _convert();
+}
 
+// falling edge on the data pin, called from the sketch's pin change interrupt
+void dht::edge()
+{
+    if (_state != DHT_CAPTURE) return;
+    unsigned long now = micros();
+    uint8_t n = _edges;
+    if (n >= 2)                         // edges 0 and 1 are the response, then one edge per bit
+    {
+        uint8_t i = n - 2;
+        unsigned long gap = now - _lastEdge;
+        if (gap > DHTLIB_BITONE)
+        {
+            _rx[i >> 3] |= (0x80 >> (i & 7));
+        }
+        if ((gap < DHTLIB_ZEROMIN) || (gap > DHTLIB_ONEMAX) || ((gap > DHTLIB_ZEROMAX) && (gap < DHTLIB_ONEMIN)))
+        {
+            _badFrame = true;
+        }
+    }
+    _lastEdge = now;
+    if (++n >= DHTLIB_EDGES)
+    {
+        _state = DHT_DONE;
+    }
+    _edges = n;
+}
+
+uint16_t dht::badframes()
+{
+    return _badFrames;
+}
+
+void dht::clearbadframes()
+{
+    _badFrames = 0;
+}
+
+int dht::_convert11()
+{
     // CONVERT AND STORE
     humidity    = bits[0];  // bits[1] == 0;
     temperature = bits[2];  // bits[3] == 0;
@@ -75,7 +190,11 @@ int dht::read(uint8_t pin)
         temperature = DHTLIB_INVALID_VALUE;  // invalid value
         return rv; // propagate error value
     }
+    return _convert();
+}
 
+int dht::_convert()
+{
     // CONVERT AND STORE
     humidity = word(bits[0], bits[1]) * 0.1;
     temperature = word(bits[2] & 0x7F, bits[3]) * 0.1;
@@ -98,6 +217,41 @@ int dht::read(uint8_t pin)
 // PRIVATE
 //
 
+// send the start signal, a short one is sent here, a long one is ended by update()
+void dht::_start(uint8_t pin, uint8_t wakeupDelay, bool dht11)
+{
+    _state = DHT_IDLE;
+    _pin = pin;
+    _wakeupDelay = wakeupDelay;
+    _dht11 = dht11;
+    _edges = 0;
+    _badFrame = false;
+    for (uint8_t i = 0; i < 5; i++) _rx[i] = 0;
+
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    if (wakeupDelay <= DHTLIB_DHT_WAKEUP)
+    {
+        delay(wakeupDelay);             // DHT22 must be released within 20ms, do not leave it to update()
+        _release();
+    }
+    else
+    {
+        _since = millis();
+        _state = DHT_WAKEUP;
+    }
+}
+
+// end the start signal and hand the line to the sensor
+void dht::_release()
+{
+    digitalWrite(_pin, HIGH);
+    delayMicroseconds(40);
+    _since = micros();
+    _state = DHT_CAPTURE;
+    pinMode(_pin, INPUT);
+}
+
 // return values:
 // DHTLIB_OK
 // DHTLIB_ERROR_TIMEOUT
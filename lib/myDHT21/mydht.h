@@ -23,6 +23,8 @@
 #define DHTLIB_OK                0
 #define DHTLIB_ERROR_CHECKSUM   -1
 #define DHTLIB_ERROR_TIMEOUT    -2
+#define DHTLIB_ERROR_FRAME      -3      // an edge came too early or too late to tell its bit
+#define DHTLIB_BUSY             -4
 #define DHTLIB_INVALID_VALUE    -999
 
 #define DHTLIB_DHT11_WAKEUP     18
@@ -35,6 +37,23 @@
 // so by dividing F_CPU by 40000 we "fail" as fast as possible
 #define DHTLIB_TIMEOUT (F_CPU/40000)
 
+// interrupt driven reading
+// a reading is 42 falling edges after the host releases the line, the
+// response, the start of bit 0, then the end of each of the 40 bits
+// a bit is 50us low then 26-28us high for 0 or 70us high for 1, so the time
+// from one falling edge to the next is about 78us for 0 and 120us for 1
+#define DHTLIB_EDGES            42
+// edge() is called late by however long other interrupts held it off, which makes
+// one gap longer and the next shorter, so a gap must fall inside the window for a
+// 0 or for a 1, anything else fails the reading with DHTLIB_ERROR_FRAME instead of
+// being decoded by the threshold and left to the checksum
+#define DHTLIB_BITONE           100     // us between falling edges above which the bit is 1
+#define DHTLIB_ZEROMIN          60      // us between falling edges allowed for a 0
+#define DHTLIB_ZEROMAX          92
+#define DHTLIB_ONEMIN           108     // and for a 1
+#define DHTLIB_ONEMAX           150
+#define DHTLIB_CAPTURE_TIMEOUT  10000   // us after release to receive all edges
+
 class dht
 {
 public:
@@ -50,12 +69,40 @@ public:
     inline int read33(uint8_t pin) { return read(pin); };
     inline int read44(uint8_t pin) { return read(pin); };
 
+    // non blocking reading
+    // start11()/start() send the start signal and return, the sketch calls
+    // edge() from its pin change interrupt on every falling edge of the data
+    // pin and update() often until it returns false, then collect() gives
+    // the same return values as read11()/read() or DHTLIB_BUSY
+    void start11(uint8_t pin);
+    void start(uint8_t pin);
+    bool update();
+    int collect();
+    void edge();
+    uint16_t badframes();               // readings failed with DHTLIB_ERROR_FRAME
+    void clearbadframes();
+
     double humidity;
     double temperature;
 
 private:
     uint8_t bits[5];  // buffer to receive data
     int _readSensor(uint8_t pin, uint8_t wakeupDelay);
+    int _convert11();
+    int _convert();
+    void _start(uint8_t pin, uint8_t wakeupDelay, bool dht11);
+    void _release();
+
+    volatile uint8_t _state;            // DHT_IDLE, DHT_WAKEUP, DHT_CAPTURE or DHT_DONE
+    volatile uint8_t _edges;            // falling edges seen since release
+    volatile uint8_t _rx[5];            // bits assembled by edge()
+    volatile unsigned long _lastEdge;   // micros() of the last falling edge
+    volatile bool _badFrame;            // edge() saw a gap outside both windows
+    uint16_t _badFrames;
+    unsigned long _since;               // millis() of the start signal, micros() of the release
+    uint8_t _pin;
+    uint8_t _wakeupDelay;
+    bool _dht11;
 };
 #endif
 //
@@ -143,7 +143,7 @@ bool DallasTemperature::readScratchPad(const uint8_t* deviceAddress, uint8_t* sc
 }
 
 
-void DallasTemperature::writeScratchPad(const uint8_t* deviceAddress, const uint8_t* scratchPad){
+void DallasTemperature::writeScratchPad(const uint8_t* deviceAddress, const uint8_t* scratchPad, bool save){
 
     _wire->reset();
     _wire->select(deviceAddress);
@@ -154,6 +154,11 @@ void DallasTemperature::writeScratchPad(const uint8_t* deviceAddress, const uint
     // DS1820 and DS18S20 have no configuration register
     if (deviceAddress[0] != DS18S20MODEL) _wire->write(scratchPad[CONFIGURATION]);
 
+    if (!save){
+        _wire->reset();
+        return;
+    }
+
     _wire->reset();
     _wire->select(deviceAddress);
 
@@ -195,7 +200,7 @@ void DallasTemperature::setResolution(uint8_t newResolution){
 
 // set resolution of a device to 9, 10, 11, or 12 bits
 // if new resolution is out of range, 9 bits is used.
-bool DallasTemperature::setResolution(const uint8_t* deviceAddress, uint8_t newResolution){
+bool DallasTemperature::setResolution(const uint8_t* deviceAddress, uint8_t newResolution, bool save){
 
     ScratchPad scratchPad;
     if (isConnected(deviceAddress, scratchPad)){
@@ -218,7 +223,7 @@ bool DallasTemperature::setResolution(const uint8_t* deviceAddress, uint8_t newR
                 scratchPad[CONFIGURATION] = TEMP_9_BIT;
                 break;
             }
-            writeScratchPad(deviceAddress, scratchPad);
+            writeScratchPad(deviceAddress, scratchPad, save);
         }
         return true;  // new value set
     }
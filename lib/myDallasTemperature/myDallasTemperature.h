@@ -89,8 +89,8 @@ public:
     // read device's scratchpad
     bool readScratchPad(const uint8_t*, uint8_t*);
 
-    // write device's scratchpad
-    void writeScratchPad(const uint8_t*, const uint8_t*);
+    // write device's scratchpad, also copied to the device EEPROM unless save is false
+    void writeScratchPad(const uint8_t*, const uint8_t*, bool save = true);
 
     // read device's power requirements
     bool readPowerSupply(const uint8_t*);
@@ -105,7 +105,9 @@ public:
     uint8_t getResolution(const uint8_t*);
 
     // set resolution of a device to 9, 10, 11, or 12 bits
-    bool setResolution(const uint8_t*, uint8_t);
+    // with save false it is not copied to the device EEPROM, quick and no wear,
+    // the device goes back to the saved resolution at power on
+    bool setResolution(const uint8_t*, uint8_t, bool save = true);
 
     // sets/gets the waitForConversion flag
     void setWaitForConversion(bool);
@@ -156,6 +158,10 @@ public:
     // convert from raw to Fahrenheit
     static float rawToFahrenheit(int16_t);
 
+    // returns the raw temperature from a scratchpad already read, for callers
+    // that read the scratchpad themselves
+    int16_t calculateTemperature(const uint8_t*, uint8_t*);
+
 #if REQUIRESNEW
 
     // initialize memory area
@@ -188,9 +194,6 @@ private:
     // Take a pointer to one wire instance
     OneWire* _wire;
 
-    // reads scratchpad and returns the raw temperature
-    int16_t calculateTemperature(const uint8_t*, uint8_t*);
-
     int16_t millisToWaitForConversion(uint8_t);
 
     void	blockTillConversionComplete(uint8_t, const uint8_t*);
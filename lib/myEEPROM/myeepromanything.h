@@ -6,7 +6,7 @@ template <class T> int EEPROM_writeAnything(int ee, const T& value)
     const byte* p = (const byte*)(const void*)&value;
     unsigned int i;
     for (i = 0; i < sizeof(value); i++)
-          EEPROM.write(ee++, *p++);
+          EEPROM.update(ee++, *p++);     // only bytes that changed are written
     return i;
 }
 
@@ -0,0 +1,94 @@
+// myFilter.h
+// Filter for one sensor reading, a median of the last TAPS readings to drop
+// single spikes followed by a first order IIR low pass to smooth the noise.
+// Readings are kept in fixed point, 1/100 of a unit in an int16_t, so the range
+// is +-327 which covers temperatures in C and humidity in %. The IIR output is
+// kept with 8 more fraction bits so small steps are not lost to rounding.
+// Each new output moves 1/2^shift of the way to the median, shift 0 turns the
+// IIR off and TAPS 1 turns the median off. Nothing is read from the sensor,
+// update() is given the reading the sketch already has.
+
+#ifndef FILTER_H
+#define FILTER_H
+
+#include <Arduino.h>
+
+template<uint8_t TAPS>
+class MedianIIR {
+  private:
+    int16_t _window[TAPS];              // last readings in 1/100
+    uint8_t _next;                      // place for the next reading
+    uint8_t _filled;                    // readings in the window
+    uint8_t _shift;
+    int32_t _state;                     // IIR output in 1/100 << 8
+    int16_t median();
+  public:
+    MedianIIR(uint8_t shift) {
+      _shift = shift;
+      reset();
+    }
+    float update(float value);
+    float value();
+    void reset();
+};
+
+// start again from the next reading
+template<uint8_t TAPS>
+void MedianIIR<TAPS>::reset()
+{
+  _next = 0;
+  _filled = 0;
+  _state = 0;
+}
+
+// sort a copy of the window, at most a handful of readings so insertion sort is fine
+template<uint8_t TAPS>
+int16_t MedianIIR<TAPS>::median()
+{
+  int16_t sorted[TAPS];
+  for ( uint8_t i = 0; i < _filled; i++ )
+  {
+    int16_t v = _window[i];
+    uint8_t j = i;
+    while ( (j > 0) && (sorted[j - 1] > v) )
+    {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = v;
+  }
+  return sorted[_filled / 2];
+}
+
+// add a reading and return the filtered value
+template<uint8_t TAPS>
+float MedianIIR<TAPS>::update(float value)
+{
+  value = constrain(value, -327.0, 327.0);
+  _window[_next] = (int16_t) (value * 100.0 + ((value < 0) ? -0.5 : 0.5));
+  _next = (_next + 1) % TAPS;
+  bool first = (_filled == 0);
+  if ( _filled < TAPS )
+  {
+    _filled++;
+  }
+  int32_t m = (int32_t) median() << 8;
+  if ( first )
+  {
+    _state = m;                         // no history, start at the reading
+  }
+  else
+  {
+    _state += (m - _state) >> _shift;
+  }
+  return _state / 25600.0;
+}
+
+// the last value update() returned, 0 before the first reading
+template<uint8_t TAPS>
+float MedianIIR<TAPS>::value()
+{
+  return _state / 25600.0;
+}
+
+#endif
@@ -0,0 +1,145 @@
+// myHealth.h
+// Health of one sensor reading, fed every reading with update().
+// A reading is used when the sensor reported it without error, it is inside the
+// plausible range and it is no more than step away from the last good reading.
+// A step that is still there after HEALTHJUMPS readings is taken as real.
+// Otherwise the last good reading is held, and after HEALTHHOLD bad readings
+// in a row the sensor is failed until a good reading comes back.
+// A sensor returning exactly the same value for HEALTHSTUCK readings is marked
+// as stuck, the value is still used as a steady reading can be real.
+// Faults (sensor reported an error) and rejects (implausible readings) are
+// counted so they can be read back over serial.
+
+#ifndef HEALTH_H
+#define HEALTH_H
+
+#include <Arduino.h>
+
+#define HEALTHHOLD    5                 // bad readings in a row before the sensor is failed
+#define HEALTHJUMPS   3                 // readings a step must last before it is believed
+#define HEALTHSTUCK   250               // identical readings in a row before the sensor is stuck
+
+#define HEALTH_OK     0
+#define HEALTH_HOLD   1                 // last reading bad, the last good one is used
+#define HEALTH_FAILED 2                 // no good reading for HEALTHHOLD readings, or none yet
+#define HEALTH_STUCK  3                 // readings good but not changing
+
+class SensorHealth {
+  private:
+    float _good;                        // last good reading
+    int8_t _lo, _hi;                    // plausible range
+    uint8_t _step;                      // largest believable change between readings
+    uint8_t _bad;                       // bad readings since the last good one
+    uint8_t _jumps;                     // readings rejected as a step in a row
+    uint8_t _same;                      // good readings with the same value in a row
+    bool _seen;                         // there has been a good reading
+    uint16_t _faults;
+    uint16_t _rejects;
+    inline float reject();
+  public:
+    SensorHealth(int8_t lo, int8_t hi, uint8_t step) {
+      _lo = lo;
+      _hi = hi;
+      _step = step;
+      _good = 0.0;
+      _bad = 0;
+      _jumps = 0;
+      _same = 0;
+      _seen = false;
+      clear();
+    }
+    inline float update(bool ok, float value);
+    inline uint8_t state();
+    inline bool failed();
+    inline float value();
+    inline uint16_t faults();
+    inline uint16_t rejects();
+    inline void clear();
+};
+
+inline float SensorHealth::reject()
+{
+  if ( _bad < 255 )
+  {
+    _bad++;
+  }
+  return _good;
+}
+
+// ok is false when the sensor reported an error, returns the reading to use
+inline float SensorHealth::update(bool ok, float value)
+{
+  if ( !ok )
+  {
+    _faults++;
+    return reject();
+  }
+  if ( (value < _lo) || (value > _hi) )
+  {
+    _rejects++;
+    return reject();
+  }
+  if ( _seen && (_bad < HEALTHHOLD) && (fabs(value - _good) > _step) && (++_jumps < HEALTHJUMPS) )
+  {
+    _rejects++;
+    return reject();
+  }
+  if ( _seen && (value == _good) )
+  {
+    if ( _same < 255 )
+    {
+      _same++;
+    }
+  }
+  else
+  {
+    _same = 0;
+  }
+  _good = value;
+  _seen = true;
+  _bad = 0;
+  _jumps = 0;
+  return value;
+}
+
+inline uint8_t SensorHealth::state()
+{
+  if ( !_seen || (_bad >= HEALTHHOLD) )
+  {
+    return HEALTH_FAILED;
+  }
+  if ( _bad > 0 )
+  {
+    return HEALTH_HOLD;
+  }
+  return (_same >= HEALTHSTUCK) ? HEALTH_STUCK : HEALTH_OK;
+}
+
+inline bool SensorHealth::failed()
+{
+  return (state() == HEALTH_FAILED);
+}
+
+inline float SensorHealth::value()
+{
+  return _good;
+}
+
+inline uint16_t SensorHealth::faults()
+{
+  return _faults;
+}
+
+inline uint16_t SensorHealth::rejects()
+{
+  return _rejects;
+}
+
+// clear the counters, the readings are kept
+inline void SensorHealth::clear()
+{
+  _faults = 0;
+  _rejects = 0;
+}
+
+#endif
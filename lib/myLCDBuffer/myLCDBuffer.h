@@ -0,0 +1,111 @@
+// myLCDBuffer.h
+// Shadow frame buffer for HD44780 character displays driven by the LCD class.
+// A page is drawn into the back buffer with the usual print() and setCursor()
+// calls, then update() compares it against what is already on the display and
+// only sends the cells that changed. This avoids lcd.clear() and a full redraw
+// for every page, which costs several I2C transactions per character and causes
+// visible flicker. update() can be given a character budget so a page is sent
+// over several passes of loop().
+
+#ifndef LCDBUFFER_H
+#define LCDBUFFER_H
+
+#include <Arduino.h>
+#include <LCD.h>
+
+template<uint8_t COLS, uint8_t ROWS>
+class LCDBuffer : public Print {
+  private:
+    LCD *_lcd;
+    uint8_t _col, _row;                 // write position in the back buffer
+    char _back[ROWS][COLS];             // frame being drawn
+    char _front[ROWS][COLS];            // frame currently on the display
+  public:
+    LCDBuffer(LCD *lcd) {
+      _lcd = lcd;
+      memset(_front, ' ', sizeof(_front));  // lcd.begin() leaves the display blank
+      clear();
+    }
+    void clear();
+    void setCursor(uint8_t col, uint8_t row);
+    void invalidate();
+    bool update(uint8_t maxcells = COLS * ROWS);
+    virtual size_t write(uint8_t c);
+    using Print::write;
+};
+
+// blank the back buffer and move the write position to 0,0
+// nothing is sent to the display until update()
+template<uint8_t COLS, uint8_t ROWS>
+void LCDBuffer<COLS, ROWS>::clear()
+{
+  memset(_back, ' ', sizeof(_back));
+  _col = 0;
+  _row = 0;
+}
+
+template<uint8_t COLS, uint8_t ROWS>
+void LCDBuffer<COLS, ROWS>::setCursor(uint8_t col, uint8_t row)
+{
+  _col = col;
+  _row = (row < ROWS) ? row : ROWS - 1;
+}
+
+// forget what is on the display so the next update() redraws every cell
+// use after writing to the lcd directly
+template<uint8_t COLS, uint8_t ROWS>
+void LCDBuffer<COLS, ROWS>::invalidate()
+{
+  memset(_front, 0, sizeof(_front));    // 0 is a CGRAM character, never printed
+}
+
+// characters past the end of a row are dropped, the display does not wrap rows in order
+template<uint8_t COLS, uint8_t ROWS>
+size_t LCDBuffer<COLS, ROWS>::write(uint8_t c)
+{
+  if ( _col < COLS )
+  {
+    _back[_row][_col] = c;
+    _col++;
+  }
+  return 1;
+}
+
+// send the cells that differ from the display, one cursor move per run of
+// changed cells, each run written with a single write() so drivers that
+// batch their bus traffic can send it in as few transactions as possible
+// at most maxcells characters are sent per call, cells already sent are clean
+// so the next call carries on where this one stopped
+// returns true when the display matches the back buffer
+template<uint8_t COLS, uint8_t ROWS>
+bool LCDBuffer<COLS, ROWS>::update(uint8_t maxcells)
+{
+  for ( uint8_t r = 0; r < ROWS; r++ )
+  {
+    uint8_t c = 0;
+    while ( c < COLS )
+    {
+      if ( _back[r][c] == _front[r][c] )
+      {
+        c++;
+        continue;
+      }
+      if ( maxcells == 0 )
+      {
+        return false;                   // out of budget for this call
+      }
+      uint8_t start = c;
+      while ( (c < COLS) && (_back[r][c] != _front[r][c]) && (maxcells > 0) )
+      {
+        _front[r][c] = _back[r][c];
+        c++;
+        maxcells--;
+      }
+      _lcd->setCursor(start, r);
+      _lcd->write((const uint8_t *) &_back[r][start], c - start);
+    }
+  }
+  return true;
+}
+
+#endif
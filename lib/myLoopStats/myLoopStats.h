@@ -0,0 +1,116 @@
+// myLoopStats.h
+// Timing of loop() passes and of named sections of code, used to find out
+// which blocking call holds up the serial commands.
+// loop() reports the length of each pass with looptime(), which keeps the
+// longest pass and a histogram of pass lengths. record() keeps the longest and
+// total time for each of N sections, the sketch decides what a section is.
+// All times are in microseconds.
+
+#ifndef LOOPSTATS_H
+#define LOOPSTATS_H
+
+#include <Arduino.h>
+
+#define LOOPBUCKETS 8                   // histogram buckets, see LoopStats::looptime()
+
+template<uint8_t N>
+class LoopStats {
+  private:
+    unsigned long _hist[LOOPBUCKETS];   // number of passes in each bucket
+    unsigned long _loopmax;             // longest pass
+    unsigned long _max[N];              // longest time in each section
+    unsigned long _total[N];            // total time in each section
+    unsigned long _count[N];            // times each section ran
+  public:
+    LoopStats() {
+      reset();
+    }
+    void reset();
+    void looptime(unsigned long us);
+    void record(uint8_t id, unsigned long us);
+    inline unsigned long bucket(uint8_t b);
+    inline unsigned long loopmax();
+    inline unsigned long passes();
+    inline unsigned long maxtime(uint8_t id);
+    inline unsigned long meantime(uint8_t id);
+};
+
+template<uint8_t N>
+void LoopStats<N>::reset()
+{
+  memset(_hist, 0, sizeof(_hist));
+  memset(_max, 0, sizeof(_max));
+  memset(_total, 0, sizeof(_total));
+  memset(_count, 0, sizeof(_count));
+  _loopmax = 0;
+}
+
+// buckets are < 250us, < 1ms, < 2ms, < 5ms, < 10ms, < 20ms, < 50ms and 50ms or more
+template<uint8_t N>
+void LoopStats<N>::looptime(unsigned long us)
+{
+  static const uint16_t limits[LOOPBUCKETS - 1] PROGMEM = { 250, 1000, 2000, 5000, 10000, 20000, 50000 };
+  uint8_t b = 0;
+  while ( (b < LOOPBUCKETS - 1) && (us >= pgm_read_word(&limits[b])) )
+  {
+    b++;
+  }
+  _hist[b]++;
+  if ( us > _loopmax )
+  {
+    _loopmax = us;
+  }
+}
+
+template<uint8_t N>
+void LoopStats<N>::record(uint8_t id, unsigned long us)
+{
+  if ( id >= N )
+  {
+    return;
+  }
+  _total[id] += us;
+  _count[id]++;
+  if ( us > _max[id] )
+  {
+    _max[id] = us;
+  }
+}
+
+template<uint8_t N>
+inline unsigned long LoopStats<N>::bucket(uint8_t b)
+{
+  return (b < LOOPBUCKETS) ? _hist[b] : 0;
+}
+
+template<uint8_t N>
+inline unsigned long LoopStats<N>::loopmax()
+{
+  return _loopmax;
+}
+
+// total number of passes recorded
+template<uint8_t N>
+inline unsigned long LoopStats<N>::passes()
+{
+  unsigned long n = 0;
+  for ( uint8_t b = 0; b < LOOPBUCKETS; b++ )
+  {
+    n += _hist[b];
+  }
+  return n;
+}
+
+template<uint8_t N>
+inline unsigned long LoopStats<N>::maxtime(uint8_t id)
+{
+  return (id < N) ? _max[id] : 0;
+}
+
+template<uint8_t N>
+inline unsigned long LoopStats<N>::meantime(uint8_t id)
+{
+  return ((id < N) && _count[id]) ? _total[id] / _count[id] : 0;
+}
+
+#endif
@@ -0,0 +1,66 @@
+// myOLEDSlice.h
+// Sends one text line of an OLED page at a time.
+// The page function prints the whole page through this object as it would to
+// the display, lines ending in println(). Only the characters of the selected
+// line are passed on to the display, the rest are dropped. Rendering a page one
+// line per pass of loop() keeps each pass to a single row of glyphs on the I2C
+// bus, so serial commands are not held up while a whole page is drawn.
+
+#ifndef OLEDSLICE_H
+#define OLEDSLICE_H
+
+#include <Arduino.h>
+#include "mySSD1306Ascii.h"
+
+class OLEDSlice : public Print {
+  private:
+    SSD1306Ascii *_oled;
+    uint8_t _line;                      // line the page function is printing
+    uint8_t _target;                    // line being sent to the display
+  public:
+    OLEDSlice(SSD1306Ascii *oled) {
+      _oled = oled;
+      _line = 0;
+      _target = 0;
+    }
+    // select the line to send and put the display cursor at the start of it
+    // call before running the page function
+    void begin(uint8_t line) {
+      _line = 0;
+      _target = line;
+      _oled->setCursor(0, line * _oled->fontRows());
+    }
+    // call after running the page function
+    // a page with fewer lines than the display leaves the selected line blank
+    void end() {
+      if ( _line <= _target )
+      {
+        _oled->clearToEOL();
+      }
+    }
+    virtual size_t write(uint8_t c) {
+      if ( c == '\r' )
+      {
+        return 1;
+      }
+      if ( _line == _target )
+      {
+        if ( c == '\n' )
+        {
+          _oled->clearToEOL();            // blank the rest of the previous contents
+        }
+        else
+        {
+          _oled->write(c);
+        }
+      }
+      if ( c == '\n' )
+      {
+        _line++;
+      }
+      return 1;
+    }
+    using Print::write;
+};
+
+#endif
@@ -88,6 +88,55 @@ void SSD1306Ascii::InverseCharOff( void )
   m_invertChar = false;
 }
 
+#if INCLUDE_SHADOW
+void SSD1306Ascii::invalidate( void )
+{
+  memset(m_shadow, 0, sizeof(m_shadow));
+}
+
+// width of a text shadow cell for the current font, zero if the font is not tracked
+uint8_t SSD1306Ascii::shadowCellWidth()
+{
+  if (!m_font || m_magFactor != 1 || readFontByte(m_font) || readFontByte(m_font + 1) || fontRows() != 1)
+  {
+    return 0;
+  }
+  return readFontByte(m_font + FONT_FIXED_WIDTH) + 1;
+}
+
+// update the shadow of one row after columns c0 to c1 were cleared
+// cells only partly cleared are still blank if they were blank, otherwise unknown
+void SSD1306Ascii::shadowClear(uint8_t c0, uint8_t c1, uint8_t row, uint8_t cw)
+{
+  if (row >= SHADOW_ROWS)
+  {
+    return;
+  }
+  if (cw == 0)
+  {
+    invalidate();
+    return;
+  }
+  for (uint8_t cell = c0 / cw; cell < SHADOW_COLS; cell++)
+  {
+    uint16_t first = cell * cw;
+    uint16_t last = first + cw - 1;
+    if (first > c1)
+    {
+      break;
+    }
+    if (first >= c0 && last <= c1)
+    {
+      m_shadow[row][cell] = ' ';
+    }
+    else if (m_shadow[row][cell] != ' ')
+    {
+      m_shadow[row][cell] = 0;
+    }
+  }
+}
+#endif  // INCLUDE_SHADOW
+
 //------------------------------------------------------------------------------
 
 uint8_t SSD1306Ascii::charWidth(uint8_t c)
@@ -123,13 +172,30 @@ void SSD1306Ascii::clear()
 void SSD1306Ascii::clear(uint8_t c0, uint8_t c1, uint8_t r0, uint8_t r1) {
   if (r1 >= displayRows())
     r1 = displayRows() - 1;
+#if INCLUDE_SHADOW
+  uint8_t cw = shadowCellWidth();
+#endif  // INCLUDE_SHADOW
   for (uint8_t r = r0; r <= r1; r++)
   {
     setCursor(c0, r);
     for (uint8_t c = c0; c <= c1; c++)
     {
+#if INCLUDE_SHADOW
+      // step over whole cells that are already blank
+      if (cw && r < SHADOW_ROWS && (c % cw) == 0 && (c / cw) < SHADOW_COLS
+          && (c + cw - 1) <= c1 && m_shadow[r][c / cw] == ' ')
+      {
+        m_col += cw;
+        m_colPending = true;
+        c += cw - 1;
+        continue;
+      }
+#endif  // INCLUDE_SHADOW
       ssd1306WriteRamBuf(0);
     }
+#if INCLUDE_SHADOW
+    shadowClear(c0, c1, r, cw);
+#endif  // INCLUDE_SHADOW
   }
   setCursor(c0, r0);
 }
@@ -157,6 +223,10 @@ void SSD1306Ascii::init(const DevType* dev)
 {
   m_col = 0;
   m_row = 0;
+#if INCLUDE_SHADOW
+  m_colPending = false;
+  invalidate();                         // display RAM contents unknown until cleared
+#endif  // INCLUDE_SHADOW
 #ifdef __AVR__
   const uint8_t* table = (const uint8_t*)pgm_read_word(&dev->initcmds);
 #else  // __AVR__
@@ -192,6 +262,9 @@ void SSD1306Ascii::setCol(uint8_t col)
   if (col >= m_displayWidth)
     return;
   m_col = col;
+#if INCLUDE_SHADOW
+  m_colPending = false;
+#endif  // INCLUDE_SHADOW
   col += m_colOffset;
   ssd1306WriteCmd(SSD1306_SETLOWCOLUMN | (col & 0XF));
   ssd1306WriteCmd(SSD1306_SETHIGHCOLUMN | (col >> 4));
@@ -236,6 +309,12 @@ void SSD1306Ascii::ssd1306WriteRam(uint8_t c)
 {
   if (m_col >= m_displayWidth)
     return;
+#if INCLUDE_SHADOW
+  if (m_colPending)
+  {
+    setCol(m_col);                      // catch up with cells skipped by the shadow
+  }
+#endif  // INCLUDE_SHADOW
   writeDisplay(c, SSD1306_MODE_RAM);
   m_col++;
 }
@@ -245,6 +324,12 @@ void SSD1306Ascii::ssd1306WriteRamBuf(uint8_t c)
 {
   if (m_col >= m_displayWidth)
     return;
+#if INCLUDE_SHADOW
+  if (m_colPending)
+  {
+    setCol(m_col);                      // catch up with cells skipped by the shadow
+  }
+#endif  // INCLUDE_SHADOW
   writeDisplay(c, SSD1306_MODE_RAM_BUF);
   m_col++;
 }
@@ -306,6 +391,36 @@ size_t SSD1306Ascii::write(uint8_t ch)
     }
     return 0;
   }
+#if INCLUDE_SHADOW
+  uint8_t cw = shadowCellWidth();
+  uint8_t cell = SHADOW_COLS;           // SHADOW_COLS when this glyph is not tracked
+  if (cw && (m_col % cw) == 0 && m_row < SHADOW_ROWS && (m_col + cw) <= m_displayWidth)
+  {
+    cell = m_col / cw;
+  }
+  if (cell < SHADOW_COLS)
+  {
+    uint8_t entry = ch | (m_invertChar ? 0X80 : 0);
+    if (m_shadow[m_row][cell] == entry)
+    {
+      m_col += cw;                      // already on the display, move on without using the bus
+      m_colPending = true;
+      return 1;
+    }
+    m_shadow[m_row][cell] = entry;
+  }
+  else if (cw)
+  {
+    for (uint8_t i = m_col / cw; i <= (m_col + cw - 1) / cw && i < SHADOW_COLS && m_row < SHADOW_ROWS; i++)
+    {
+      m_shadow[m_row][i] = 0;           // unaligned glyph, the cells it overlaps are unknown
+    }
+  }
+  else
+  {
+    invalidate();
+  }
+#endif  // INCLUDE_SHADOW
   ch -= first;
   uint8_t s = m_magFactor;
   uint8_t thieleShift = 0;
@@ -359,6 +474,14 @@ size_t SSD1306Ascii::write(uint8_t ch)
       }
       for (uint8_t i = 0; i < s; i++)
       {
+#if INCLUDE_SHADOW
+        if (cell < SHADOW_COLS && (i + 1) == s)
+        {
+          // last byte of a tracked glyph ends the buffered I2C transaction
+          ssd1306WriteRam(m_invertChar ? 0b01111111 : 0);
+          continue;
+        }
+#endif  // INCLUDE_SHADOW
         if ( m_invertChar == false )
           ssd1306WriteRamBuf(0);
         else
@@ -366,6 +489,12 @@ size_t SSD1306Ascii::write(uint8_t ch)
       }
     }
   }
+#if INCLUDE_SHADOW
+  if (cell < SHADOW_COLS)
+  {
+    return 1;                           // single row glyph, the page address has not moved
+  }
+#endif  // INCLUDE_SHADOW
   setRow(srow);
   return 1;
 }
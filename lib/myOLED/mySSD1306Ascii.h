@@ -54,6 +54,26 @@
 /** Use larger faster I2C code. */
 #define OPTIMIZE_I2C 1
 
+/** Keep a text shadow of display RAM.
+
+   If INCLUDE_SHADOW is defined to be one, the character and invert state
+   of every cell is remembered for each eight pixel row. write() skips a
+   glyph that is already on the display and clear() skips cells that are
+   already blank, the column address is only sent again before the next
+   byte that really changes. Reprinting a page then only costs the bus
+   traffic of the characters that changed, and the changed glyphs that
+   follow each other go out in the buffered OPTIMIZE_I2C transactions.
+
+   Only fixed width fonts at magnification one are tracked, cells are
+   the font width plus the one pixel space. This costs
+   SHADOW_COLS * SHADOW_ROWS + 1 bytes of RAM.
+*/
+#define INCLUDE_SHADOW 1
+#if INCLUDE_SHADOW
+#define SHADOW_COLS  21         // 128 pixels / 6 pixel cells
+#define SHADOW_ROWS  8          // 64 pixels / 8 pixel rows
+#endif  // INCLUDE_SHADOW
+
 /** Define OPTIMIZE_AVR_SPI non-zero for a faster smaller AVR SPI code.
    Warning AVR will not use SPI transactions.
 */
@@ -291,6 +311,13 @@ class SSD1306Ascii : public Print
     void Display_Bright( void );
     void Display_Dim( void );
     void Display_Rotate( int m );
+#if INCLUDE_SHADOW
+    /**
+       @brief Forget the text shadow so the next write of every cell is sent.
+       @note Use after writing to display RAM other than with write() or clear().
+    */
+    void invalidate( void );
+#endif  // INCLUDE_SHADOW
 
 private:
       virtual void writeDisplay(uint8_t b, uint8_t mode) = 0;
@@ -305,6 +332,12 @@ private:
       uint8_t m_scroll;          // Scroll mode
 #endif  // INCLUDE_SCROLLING    
       const uint8_t* m_font;     // Current font.
+#if INCLUDE_SHADOW
+      uint8_t shadowCellWidth();
+      void shadowClear(uint8_t c0, uint8_t c1, uint8_t row, uint8_t cw);
+      boolean m_colPending;      // m_col not yet sent to the controller
+      uint8_t m_shadow[SHADOW_ROWS][SHADOW_COLS];  // char | 0X80 if inverted, 0 = unknown
+#endif  // INCLUDE_SHADOW
     };
 #endif  // SSD1306Ascii_h
 
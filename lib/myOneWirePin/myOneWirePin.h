@@ -0,0 +1,175 @@
+// myOneWirePin.h
+// OneWire bus on a pin that is fixed at compile time, ATmega328P digital pins 0-19.
+// The port registers and bit mask are constants, so each pin change in the bit
+// timing is a single sbi or cbi instruction instead of a read, modify and write
+// through the register pointer kept by OneWire. Everything that is not timing
+// critical is done before interrupts are turned off, which keeps the windows
+// where a software UART cannot time its bits as short as the bus allows. The 65us
+// low part of a 0 is the longest, it is sent with interrupts off, as interrupts
+// stretching it past 120us would look like a reset to the devices.
+// The delays are the same as OneWire.cpp.
+// DallasTemperature still takes a OneWire*, the bus functions are virtual so it
+// gets these versions, one virtual call per byte rather than per bit.
+
+#ifndef ONEWIREPIN_H
+#define ONEWIREPIN_H
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+template<uint8_t PIN>
+class OneWirePin : public OneWire {
+  private:
+    static_assert(PIN < 20, "OneWirePin needs a pin from 0 to 19");
+    static const uint8_t MASK = _BV((PIN < 8) ? PIN : ((PIN < 14) ? (PIN - 8) : (PIN - 14)));
+    static inline volatile uint8_t &in() {
+      return (PIN < 8) ? PIND : ((PIN < 14) ? PINB : PINC);
+    }
+    static inline volatile uint8_t &ddr() {
+      return (PIN < 8) ? DDRD : ((PIN < 14) ? DDRB : DDRC);
+    }
+    static inline volatile uint8_t &out() {
+      return (PIN < 8) ? PORTD : ((PIN < 14) ? PORTB : PORTC);
+    }
+    static inline void drivelow() {
+      out() &= ~MASK;
+      ddr() |= MASK;
+    }
+    static inline void drivehigh() {
+      out() |= MASK;
+    }
+    static inline void release() {
+      ddr() &= ~MASK;
+    }
+    static inline uint8_t sense() {
+      return (in() & MASK) ? 1 : 0;
+    }
+    inline void sendbit(uint8_t v);
+    inline uint8_t takebit();
+  public:
+    OneWirePin() : OneWire(PIN) {
+    }
+    virtual uint8_t reset(void);
+    virtual void write(uint8_t v, uint8_t power = 0);
+    virtual uint8_t read(void);
+    virtual void write_bit(uint8_t v);
+    virtual uint8_t read_bit(void);
+};
+
+// same as OneWire::reset() but interrupts stay on throughout, OneWire turns them off for
+// 70us to sample the wire once, longer than half a bit of a 9600 baud software UART
+// a presence pulse starts 15-60us after the wire is released and lasts at least 60us, so
+// the wire is polled from 10us to about 85us and any low seen counts, an interrupt in
+// between only makes the window longer
+// returns 1 if a device answered with a presence pulse
+template<uint8_t PIN>
+uint8_t OneWirePin<PIN>::reset(void)
+{
+  uint8_t retries = 125;
+  release();                            // one cbi, no need to turn interrupts off
+  do                                    // wait until the wire is high... just in case
+  {
+    if ( --retries == 0 )
+    {
+      return 0;
+    }
+    delayMicroseconds(2);
+  } while ( !sense() );
+
+  drivelow();
+  delayMicroseconds(480);
+  release();
+  delayMicroseconds(10);                // let the pull up raise the wire
+  uint8_t r = 0;
+  for ( uint8_t i = 0; i < 30; i++ )
+  {
+    if ( !sense() )
+    {
+      r = 1;
+    }
+    delayMicroseconds(2);
+  }
+  delayMicroseconds(400);               // rest of the 480us presence slot
+  return r;
+}
+
+// bit timing shared by write() and write_bit(), always leaves the bus driven high
+template<uint8_t PIN>
+inline void OneWirePin<PIN>::sendbit(uint8_t v)
+{
+  if ( v & 1 )
+  {
+    noInterrupts();
+    drivelow();
+    delayMicroseconds(10);
+    drivehigh();
+    interrupts();
+    delayMicroseconds(55);
+  }
+  else
+  {
+    noInterrupts();
+    drivelow();
+    delayMicroseconds(65);
+    drivehigh();
+    interrupts();
+    delayMicroseconds(5);
+  }
+}
+
+template<uint8_t PIN>
+inline uint8_t OneWirePin<PIN>::takebit()
+{
+  noInterrupts();
+  drivelow();
+  delayMicroseconds(3);
+  release();                            // let pin float, pull up will raise
+  delayMicroseconds(10);
+  uint8_t r = sense();
+  interrupts();
+  delayMicroseconds(53);
+  return r;
+}
+
+// leaves the bus powered if power is 1, for parasite powered devices
+template<uint8_t PIN>
+void OneWirePin<PIN>::write(uint8_t v, uint8_t power)
+{
+  for ( uint8_t bitmask = 0x01; bitmask; bitmask <<= 1 )
+  {
+    sendbit(v & bitmask ? 1 : 0);
+  }
+  if ( !power )
+  {
+    release();
+    out() &= ~MASK;
+  }
+}
+
+template<uint8_t PIN>
+uint8_t OneWirePin<PIN>::read(void)
+{
+  uint8_t r = 0;
+  for ( uint8_t bitmask = 0x01; bitmask; bitmask <<= 1 )
+  {
+    if ( takebit() )
+    {
+      r |= bitmask;
+    }
+  }
+  return r;
+}
+
+template<uint8_t PIN>
+void OneWirePin<PIN>::write_bit(uint8_t v)
+{
+  sendbit(v);
+}
+
+template<uint8_t PIN>
+uint8_t OneWirePin<PIN>::read_bit(void)
+{
+  return takebit();
+}
+
+#endif
@@ -0,0 +1,307 @@
+// myProbes.h
+// Registry of the DS18B20 probes on every 1-Wire bus.
+// Each bus is scanned once at start up with addbus() and every device found is
+// kept with its ROM code, the bus it is on and the logical channel it reports
+// to. A device reports to the channel of its bus unless bind() moves it to
+// another one, so with no bindings the controller works as one probe per bus.
+// The devices on one channel are averaged, and one bus can carry every channel.
+// Channels are numbered from 1, channel 0 means the device is not used.
+// request() starts one conversion on each bus without waiting for it. Once the
+// conversion time has passed, each call of update() reads one scratchpad, so a
+// read of many probes is spread over as many scheduler ticks. A scratchpad that
+// fails its CRC is read again on the next tick, up to PROBERETRIES times. So is
+// one holding 85C, the power on value left by a probe that reset during the
+// conversion. Every failed read is counted in readerrors().
+// temperature() only works on the readings kept, it does not use the bus.
+// Each device can have its own resolution, the reads start when the slowest
+// device in use has finished converting.
+
+#ifndef PROBES_H
+#define PROBES_H
+
+#include <Arduino.h>
+#include <myDallasTemperature.h>
+
+#define PROBERETRIES 2                  // further reads of a scratchpad that failed its CRC
+#define PROBEPOWERON 10880              // 85C in 1/128C, the scratchpad value at power on
+
+// ROM code to channel binding as kept in the config, an unused entry has rom[0] == 0
+// which is never a valid family code
+struct ProbeBinding {
+  DeviceAddress rom;
+  uint8_t channel;
+};
+
+struct ProbeDevice {
+  DeviceAddress rom;
+  uint8_t bus;                          // index of the bus in the order it was added
+  uint8_t channel;
+  int16_t raw;                          // last reading in 1/128C, DEVICE_DISCONNECTED_RAW if it failed
+  uint8_t bits;                         // resolution set, 9 to 12
+};
+
+template<uint8_t BUSES, uint8_t N>
+class ProbeRegistry {
+  private:
+    DallasTemperature *_bus[BUSES];
+    uint8_t _buschannel[BUSES];         // channel a device on this bus reports to by default
+    ProbeDevice _devices[N];
+    uint8_t _buses;
+    uint8_t _count;
+    uint8_t _next;                      // next device to read, _count when every device has been read
+    uint8_t _tries;                     // failed reads of the next device
+    uint16_t _convtime;                 // ms the slowest device in use takes to convert
+    unsigned long _requested;           // millis() when the conversion was started
+    uint16_t _readerrors;               // scratchpad reads that failed
+    void updateconvtime();
+  public:
+    ProbeRegistry() {
+      _buses = 0;
+      _count = 0;
+      _next = 0;
+      _tries = 0;
+      _convtime = 750;
+      _readerrors = 0;
+    }
+    uint8_t addbus(DallasTemperature *dt, uint8_t channel);
+    void bind(const uint8_t *rom, uint8_t channel);
+    void unbind();
+    void setresolution(uint8_t bits);
+    void channelresolution(uint8_t channel, uint8_t bits);
+    void request();
+    bool update();
+    float temperature(uint8_t channel);
+    uint8_t devices(uint8_t channel);
+    inline uint16_t readerrors();
+    inline void clearerrors();
+    inline uint8_t count();
+    inline const ProbeDevice &device(uint8_t id);
+};
+
+// scan a bus that has had begin() called, returns the number of devices added
+// devices beyond N are not kept
+template<uint8_t BUSES, uint8_t N>
+uint8_t ProbeRegistry<BUSES, N>::addbus(DallasTemperature *dt, uint8_t channel)
+{
+  if ( _buses >= BUSES )
+  {
+    return 0;
+  }
+  uint8_t bus = _buses++;
+  _bus[bus] = dt;
+  _buschannel[bus] = channel;
+  dt->setWaitForConversion(false);      // update() collects the readings
+
+  uint8_t found = 0;
+  uint8_t n = dt->getDeviceCount();
+  for ( uint8_t i = 0; (i < n) && (_count < N); i++ )
+  {
+    ProbeDevice &d = _devices[_count];
+    if ( dt->getAddress(d.rom, i) )
+    {
+      d.bus = bus;
+      d.channel = channel;
+      d.raw = DEVICE_DISCONNECTED_RAW;
+      d.bits = 12;                      // power on default until setresolution()
+      _count++;
+      found++;
+    }
+  }
+  return found;
+}
+
+// move the device with this ROM code to a channel, unknown ROM codes are ignored
+template<uint8_t BUSES, uint8_t N>
+void ProbeRegistry<BUSES, N>::bind(const uint8_t *rom, uint8_t channel)
+{
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    if ( memcmp(_devices[i].rom, rom, sizeof(DeviceAddress)) == 0 )
+    {
+      _devices[i].channel = channel;
+    }
+  }
+  updateconvtime();
+}
+
+// put every device back on the channel of its bus
+template<uint8_t BUSES, uint8_t N>
+void ProbeRegistry<BUSES, N>::unbind()
+{
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    _devices[i].channel = _buschannel[_devices[i].bus];
+  }
+  updateconvtime();
+}
+
+// set and save the resolution of every device, done at start up
+template<uint8_t BUSES, uint8_t N>
+void ProbeRegistry<BUSES, N>::setresolution(uint8_t bits)
+{
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    _bus[_devices[i].bus]->setResolution(_devices[i].rom, bits);
+    _devices[i].bits = bits;
+  }
+  updateconvtime();
+}
+
+// change the resolution of the devices on a channel without saving it in the device,
+// only the devices not already at that resolution are written
+// call between a read and the next request(), not while a conversion is running
+template<uint8_t BUSES, uint8_t N>
+void ProbeRegistry<BUSES, N>::channelresolution(uint8_t channel, uint8_t bits)
+{
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    ProbeDevice &d = _devices[i];
+    if ( (d.channel == channel) && (d.bits != bits) )
+    {
+      if ( _bus[d.bus]->setResolution(d.rom, bits, false) )
+      {
+        d.bits = bits;
+      }
+    }
+  }
+  updateconvtime();
+}
+
+// 94ms at 9 bits up to 750ms at 12 bits
+template<uint8_t BUSES, uint8_t N>
+void ProbeRegistry<BUSES, N>::updateconvtime()
+{
+  uint8_t bits = 9;
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    if ( (_devices[i].channel != 0) && (_devices[i].bits > bits) )
+    {
+      bits = _devices[i].bits;
+    }
+  }
+  _convtime = 750 >> (12 - bits);
+}
+
+// start a conversion on every bus that has a device in use, one skip rom and convert
+// command per bus, update() reads the results
+template<uint8_t BUSES, uint8_t N>
+void ProbeRegistry<BUSES, N>::request()
+{
+  _requested = millis();
+  _next = 0;
+  _tries = 0;
+  for ( uint8_t bus = 0; bus < _buses; bus++ )
+  {
+    for ( uint8_t i = 0; i < _count; i++ )
+    {
+      if ( (_devices[i].bus == bus) && (_devices[i].channel != 0) )
+      {
+        _bus[bus]->requestTemperatures();
+        break;
+      }
+    }
+  }
+}
+
+// read the scratchpad of the next device once the conversion is done
+// returns true while there are devices left to read
+template<uint8_t BUSES, uint8_t N>
+bool ProbeRegistry<BUSES, N>::update()
+{
+  while ( (_next < _count) && (_devices[_next].channel == 0) )
+  {
+    _next++;                            // not used, not converted
+  }
+  if ( _next >= _count )
+  {
+    return false;
+  }
+  if ( (millis() - _requested) < _convtime )
+  {
+    return true;
+  }
+  ProbeDevice &d = _devices[_next];
+  DallasTemperature *dt = _bus[d.bus];
+  uint8_t scratchpad[9];
+  int16_t raw = DEVICE_DISCONNECTED_RAW;
+  if ( dt->readScratchPad(d.rom, scratchpad) && (OneWire::crc8(scratchpad, 8) == scratchpad[8]) )
+  {
+    raw = dt->calculateTemperature(d.rom, scratchpad);
+  }
+  if ( (raw == DEVICE_DISCONNECTED_RAW) || (raw == PROBEPOWERON) )
+  {
+    if ( _readerrors < 0xFFFF )
+    {
+      _readerrors++;
+    }
+    if ( _tries < PROBERETRIES )
+    {
+      _tries++;                         // try this device again on the next call
+      return true;
+    }
+    raw = DEVICE_DISCONNECTED_RAW;
+  }
+  d.raw = raw;
+  _tries = 0;
+  _next++;
+  return (_next < _count);
+}
+
+// average of the devices on a channel with a good reading
+// DEVICE_DISCONNECTED_C if there is none, as getTempC() does for one device
+template<uint8_t BUSES, uint8_t N>
+float ProbeRegistry<BUSES, N>::temperature(uint8_t channel)
+{
+  long total = 0;
+  uint8_t good = 0;
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    if ( (_devices[i].channel == channel) && (_devices[i].raw != DEVICE_DISCONNECTED_RAW) )
+    {
+      total += _devices[i].raw;
+      good++;
+    }
+  }
+  return (good == 0) ? DEVICE_DISCONNECTED_C : DallasTemperature::rawToCelsius(total / good);
+}
+
+// number of devices reporting to a channel
+template<uint8_t BUSES, uint8_t N>
+uint8_t ProbeRegistry<BUSES, N>::devices(uint8_t channel)
+{
+  uint8_t n = 0;
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    if ( _devices[i].channel == channel )
+    {
+      n++;
+    }
+  }
+  return n;
+}
+
+template<uint8_t BUSES, uint8_t N>
+inline uint16_t ProbeRegistry<BUSES, N>::readerrors()
+{
+  return _readerrors;
+}
+
+template<uint8_t BUSES, uint8_t N>
+inline void ProbeRegistry<BUSES, N>::clearerrors()
+{
+  _readerrors = 0;
+}
+
+template<uint8_t BUSES, uint8_t N>
+inline uint8_t ProbeRegistry<BUSES, N>::count()
+{
+  return _count;
+}
+
+template<uint8_t BUSES, uint8_t N>
+inline const ProbeDevice &ProbeRegistry<BUSES, N>::device(uint8_t id)
+{
+  return _devices[id];
+}
+
+#endif
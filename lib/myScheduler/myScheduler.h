@@ -0,0 +1,158 @@
+// myScheduler.h
+// Small cooperative scheduler with a fixed task table.
+// Each task is a plain function with a period in milliseconds. run() is called
+// from loop() and calls every task that is due, in the order they were added.
+// Elapsed times are worked out as now - last with unsigned arithmetic, so the
+// millis() wrap after 49.7 days needs no special case.
+// For every task the scheduler keeps how late it started (jitter), how long it
+// ran and how often it started later than its deadline.
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+typedef void (*TaskFunc)(void);
+
+struct Task {
+  TaskFunc fn;
+  uint16_t period;                      // ms between runs, 0 = every pass of run()
+  uint16_t deadline;                    // ms a start may be late before it counts as a miss
+  unsigned long last;                   // millis() when the task was last due
+  uint16_t maxlate;                     // worst start jitter seen in ms
+  uint16_t maxtime;                     // longest run seen in us, saturates at 65535
+  uint16_t misses;                      // starts later than the deadline
+};
+
+template<uint8_t N>
+class Scheduler {
+  private:
+    Task _tasks[N];
+    uint8_t _count;
+  public:
+    Scheduler() {
+      _count = 0;
+    }
+    uint8_t add(TaskFunc fn, uint16_t period, uint16_t deadline);
+    void begin();
+    void run();
+    void setperiod(uint8_t id, uint16_t period);
+    void trigger(uint8_t id);
+    void resetstats();
+    inline uint8_t count();
+    inline const Task &task(uint8_t id);
+};
+
+// add a task, returns its id which is its place in the table
+// tasks beyond N are dropped and get id N
+template<uint8_t N>
+uint8_t Scheduler<N>::add(TaskFunc fn, uint16_t period, uint16_t deadline)
+{
+  if ( _count >= N )
+  {
+    return N;
+  }
+  Task &t = _tasks[_count];
+  t.fn = fn;
+  t.period = period;
+  t.deadline = deadline;
+  t.last = millis();
+  t.maxlate = 0;
+  t.maxtime = 0;
+  t.misses = 0;
+  return _count++;
+}
+
+// start every period from now, first runs are one period away
+template<uint8_t N>
+void Scheduler<N>::begin()
+{
+  unsigned long now = millis();
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    _tasks[i].last = now;
+  }
+}
+
+template<uint8_t N>
+void Scheduler<N>::run()
+{
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    Task &t = _tasks[i];
+    unsigned long now = millis();
+    unsigned long elapsed = now - t.last;
+    if ( elapsed < t.period )
+    {
+      continue;
+    }
+    unsigned long late = elapsed - t.period;
+    if ( late > t.period )
+    {
+      t.last = now;                     // fell more than a period behind, do not try to catch up
+    }
+    else
+    {
+      t.last += t.period;               // keep to the period, no drift
+    }
+    if ( (t.period != 0) && (late > t.deadline) )
+    {
+      t.misses++;
+    }
+    if ( late > t.maxlate )
+    {
+      t.maxlate = (late > 0xFFFF) ? 0xFFFF : late;
+    }
+    unsigned long start = micros();
+    t.fn();
+    unsigned long took = micros() - start;
+    if ( took > t.maxtime )
+    {
+      t.maxtime = (took > 0xFFFF) ? 0xFFFF : took;
+    }
+  }
+}
+
+template<uint8_t N>
+void Scheduler<N>::setperiod(uint8_t id, uint16_t period)
+{
+  if ( id < _count )
+  {
+    _tasks[id].period = period;
+  }
+}
+
+// make the task due on the next run()
+template<uint8_t N>
+void Scheduler<N>::trigger(uint8_t id)
+{
+  if ( id < _count )
+  {
+    _tasks[id].last = millis() - _tasks[id].period;
+  }
+}
+
+template<uint8_t N>
+void Scheduler<N>::resetstats()
+{
+  for ( uint8_t i = 0; i < _count; i++ )
+  {
+    _tasks[i].maxlate = 0;
+    _tasks[i].maxtime = 0;
+    _tasks[i].misses = 0;
+  }
+}
+
+template<uint8_t N>
+inline uint8_t Scheduler<N>::count()
+{
+  return _count;
+}
+
+template<uint8_t N>
+inline const Task &Scheduler<N>::task(uint8_t id)
+{
+  return _tasks[id];
+}
+
+#endif
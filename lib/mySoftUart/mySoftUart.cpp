@@ -0,0 +1,251 @@
+// mySoftUart.cpp
+// Software UART on timer 2, see mySoftUart.h
+
+#include <mySoftUart.h>
+
+SoftUart softuart;
+
+static void (*rxhandler)(char c, bool ok);
+static uint8_t rxmask;                  // RX bit in PINB
+static uint8_t txmask;                  // TX bit in PORTB
+static uint8_t halfbit;                 // timer 2 ticks in half a bit
+static volatile uint8_t rxstate;        // 0 waiting for a start bit, 1 start bit, 2-9 data bits, 10 stop bit
+static uint8_t rxbyte;
+
+static volatile char txbuf[SOFTUARTTXSIZE];
+static volatile uint8_t txhead;         // next free place in txbuf
+static volatile uint8_t txtail;         // next byte to send
+static uint16_t txstalls;               // print() calls that waited for room in the ring
+static uint8_t txpeak;                  // most bytes seen waiting in the ring
+
+static inline uint8_t txused()
+{
+  return (txhead - txtail) & (SOFTUARTTXSIZE - 1);
+}
+
+// count a wait before n bytes go in the ring
+static inline void txroom(size_t n)
+{
+  if ( (n > (size_t) (SOFTUARTTXSIZE - 1 - txused())) && (txstalls < 0xFFFF) )
+  {
+    txstalls++;
+  }
+}
+
+static inline void txsent()
+{
+  uint8_t used = txused();
+  if ( used > txpeak )
+  {
+    txpeak = used;
+  }
+}
+static volatile uint8_t txstate;        // 0 idle, 1-8 data bits next, 9 stop bit next
+static uint8_t txbyte;
+
+static volatile uint8_t *pwmport;       // output pulsed by compare A, NULL for none
+static uint8_t pwmmask;
+static volatile uint8_t pwmvalue;
+static uint8_t pwmcount;
+
+// falling edge on RX, the start of a byte
+ISR(PCINT0_vect)
+{
+  if ( (rxstate != 0) || (PINB & rxmask) )
+  {
+    return;
+  }
+  PCMSK0 &= ~rxmask;                    // no more edges until the stop bit
+  uint16_t t = TCNT2 + halfbit;
+  if ( t > OCR2A )
+  {
+    t -= OCR2A + 1;
+  }
+  OCR2B = t;                            // the middle of the start bit
+  TIFR2 = _BV(OCF2B);
+  TIMSK2 |= _BV(OCIE2B);
+  rxstate = 1;
+}
+
+// middle of a received bit
+ISR(TIMER2_COMPB_vect)
+{
+  bool high = PINB & rxmask;
+  uint8_t state = rxstate;
+  if ( state == 1 )
+  {
+    if ( high )
+    {
+      state = 11;                       // a glitch, not a start bit
+    }
+  }
+  else if ( state <= 9 )
+  {
+    rxbyte >>= 1;
+    if ( high )
+    {
+      rxbyte |= 0x80;
+    }
+  }
+  else
+  {
+    rxhandler(rxbyte, high);
+  }
+  if ( ++state > 10 )
+  {
+    TIMSK2 &= ~_BV(OCIE2B);
+    PCIFR = _BV(PCIF0);                 // forget the edges inside the byte
+    PCMSK0 |= rxmask;
+    state = 0;
+  }
+  rxstate = state;
+}
+
+// one bit time, next bit to send and the PWM output
+ISR(TIMER2_COMPA_vect)
+{
+  uint8_t state = txstate;
+  if ( state == 0 )
+  {
+    if ( txhead != txtail )
+    {
+      txbyte = txbuf[txtail];
+      txtail = (txtail + 1) & (SOFTUARTTXSIZE - 1);
+      PORTB &= ~txmask;                 // start bit
+      state = 1;
+    }
+  }
+  else if ( state <= 8 )
+  {
+    if ( txbyte & 1 )
+    {
+      PORTB |= txmask;
+    }
+    else
+    {
+      PORTB &= ~txmask;
+    }
+    txbyte >>= 1;
+    state++;
+  }
+  else
+  {
+    PORTB |= txmask;                    // stop bit
+    state = 0;
+  }
+  txstate = state;
+
+  if ( pwmport != NULL )
+  {
+    if ( ++pwmcount >= 255 )
+    {
+      pwmcount = 0;
+    }
+    if ( (pwmcount == 0) && (pwmvalue != 0) )
+    {
+      *pwmport |= pwmmask;
+    }
+    else if ( pwmcount == pwmvalue )
+    {
+      *pwmport &= ~pwmmask;
+    }
+  }
+}
+
+void SoftUart::begin(unsigned long baud, uint8_t rxpin, uint8_t txpin, void (*rx)(char c, bool ok))
+{
+  rxhandler = rx;
+  rxmask = digitalPinToBitMask(rxpin);
+  txmask = digitalPinToBitMask(txpin);
+  pinMode(rxpin, INPUT_PULLUP);
+  digitalWrite(txpin, HIGH);            // idle
+  pinMode(txpin, OUTPUT);
+  uint8_t top = (F_CPU / 8 + baud / 2) / baud - 1;
+  halfbit = (top + 1) / 2;
+
+  noInterrupts();
+  rxstate = 0;
+  txstate = 0;
+  txhead = 0;
+  txtail = 0;
+  TCCR2A = _BV(WGM21);                  // CTC, TOP is OCR2A
+  TCCR2B = _BV(CS21);                   // F_CPU / 8
+  OCR2A = top;
+  TCNT2 = 0;
+  TIFR2 = _BV(OCF2A) | _BV(OCF2B);
+  TIMSK2 = _BV(OCIE2A);
+  PCMSK0 |= rxmask;
+  PCIFR = _BV(PCIF0);
+  PCICR |= _BV(PCIE0);
+  interrupts();
+}
+
+// waits while the ring is full, with interrupts off a byte that does not fit is lost
+void SoftUart::write(char c)
+{
+  uint8_t next = (txhead + 1) & (SOFTUARTTXSIZE - 1);
+  while ( next == txtail )
+  {
+    if ( !(SREG & _BV(SREG_I)) )
+    {
+      return;
+    }
+  }
+  txbuf[txhead] = c;
+  txhead = next;
+}
+
+void SoftUart::print(const char *str)
+{
+  txroom(strlen(str));
+  while ( *str != 0 )
+  {
+    write(*str++);
+  }
+  txsent();
+}
+
+// wait until every byte in the ring has been sent
+void SoftUart::flush()
+{
+  while ( (txhead != txtail) || (txstate != 0) )
+  {
+  }
+}
+
+// a byte is being sent or received, or is waiting to be sent
+bool SoftUart::busy()
+{
+  return (txhead != txtail) || (txstate != 0) || (rxstate != 0);
+}
+
+// value 0-255 as for analogWrite(), 0 is off and 255 is on
+void SoftUart::setpwm(uint8_t pin, uint8_t value)
+{
+  if ( pwmport == NULL )
+  {
+    pinMode(pin, OUTPUT);
+    digitalWrite(pin, LOW);
+    pwmmask = digitalPinToBitMask(pin);
+    noInterrupts();
+    pwmport = portOutputRegister(digitalPinToPort(pin));
+    interrupts();
+  }
+  pwmvalue = value;
+}
+
+uint16_t SoftUart::stalls()
+{
+  return txstalls;
+}
+
+uint8_t SoftUart::peak()
+{
+  return txpeak;
+}
+
+void SoftUart::clearstats()
+{
+  txstalls = 0;
+  txpeak = 0;
+}
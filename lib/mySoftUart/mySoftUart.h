@@ -0,0 +1,45 @@
+// mySoftUart.h
+// Software UART on timer 2, used for the bluetooth adapter instead of SoftwareSerial.
+// SoftwareSerial turns interrupts off for the whole of every byte it sends or
+// receives, about 1ms at 9600 baud. Here timer 2 runs in CTC mode with one compare A
+// match per bit time. Compare A puts the next bit of the byte being sent on the TX
+// pin. A falling edge on the RX pin, seen by pin change interrupt 0, sets compare B
+// half a bit later, so compare B samples the middle of each received bit. Sending
+// and receiving run at the same time and interrupts are only held off for the few
+// microseconds each handler takes.
+// RX and TX must be PORTB pins, 8 to 13, and only RX may use pin change interrupt 0.
+// Timer 2 is set for bit times of 32 to 256 ticks at F_CPU / 8, 9600 and 19200 baud
+// at 16MHz.
+// Each received byte is handed to the function given to begin() from the interrupt,
+// ok is false when its stop bit was low, so the byte is garbled. Sent bytes go
+// through a ring of SOFTUARTTXSIZE bytes, waits for room in it are counted in
+// stalls() and the most bytes seen waiting is kept in peak(), as for myUart.
+// analogWrite() no longer works on pins 3 and 11 once timer 2 is taken, so compare A
+// also pulses one output pin, setpwm() takes the same 0-255 value as analogWrite().
+// Its period is 255 bit times, about 38Hz at 9600 baud.
+// Anything else that turns interrupts off for more than half a bit, 52us at 9600
+// baud, shifts the bits and garbles the byte, busy() tells when to hold off.
+
+#ifndef SOFTUART_H
+#define SOFTUART_H
+
+#include <Arduino.h>
+
+#define SOFTUARTTXSIZE 64               // bytes waiting to be sent, a power of 2
+
+class SoftUart {
+  public:
+    void begin(unsigned long baud, uint8_t rxpin, uint8_t txpin, void (*rx)(char c, bool ok));
+    void write(char c);
+    void print(const char *str);
+    void flush();
+    uint16_t stalls();
+    uint8_t peak();
+    void clearstats();
+    bool busy();
+    void setpwm(uint8_t pin, uint8_t value);
+};
+
+extern SoftUart softuart;
+
+#endif
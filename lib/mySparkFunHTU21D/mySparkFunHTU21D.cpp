@@ -18,6 +18,9 @@
  Call HTU21D.Begin() in setup.
  HTU21D.ReadHumidity() will return a float containing the humidity. Ex: 54.7
  HTU21D.ReadTemperature() will return a float containing the temperature in Celsius. Ex: 24.1
+ HTU21D.triggerTemperature() / triggerHumidity() start a measurement and return straight away
+ HTU21D.collectTemperature() / collectHumidity() return the result, 997 while the sensor is still measuring
+ HTU21D.measureTime(humidity) returns the ms a measurement takes at the current resolution
  HTU21D.SetResolution(byte: 0b.76543210) sets the resolution of the readings.
  HTU2ID.softReset() will do a software reset (15ms)
  HTU21D.check_crc(message, check_value) verifies the 8-bit CRC generated by the sensor
@@ -33,6 +36,9 @@
 HTU21D::HTU21D()
 {
   //Set initial values for private vars
+  _resolution = 0;
+  _measureTime = 0;
+  _triggered = 0;
 }
 
 //Begin
@@ -50,43 +56,59 @@ void HTU21D::begin(void)
 //Returns 999 if CRC is wrong
 float HTU21D::readHumidity(void)
 {
-  //Request a humidity reading
-  Wire.beginTransmission(HTDU21D_ADDRESS);
-  Wire.write(TRIGGER_HUMD_MEASURE_NOHOLD); //Measure humidity with no bus holding
-  Wire.endTransmission();
-
-  //Hang out while measurement is taken. 50mS max, page 4 of datasheet.
-  delay(55);
-
-  //Comes back in three bytes, data(MSB) / data(LSB) / Checksum
-  Wire.requestFrom(HTDU21D_ADDRESS, 3);
+  triggerHumidity();
 
-  //Wait for data to become available
-  int counter = 0;
-  while (Wire.available() < 3)
+  //Hang out while measurement is taken, 16mS max at 12 bit, page 3 of datasheet
+  float rh;
+  while ((rh = collectHumidity()) == HTU21D_NOTREADY)
   {
-    counter++;
     delay(1);
-    if (counter > 100) return 998; //Error out
   }
+  return (rh);
+}
 
-  byte msb, lsb, checksum;
-  msb = Wire.read();
-  lsb = Wire.read();
-  checksum = Wire.read();
+//Read the temperature
+/*******************************************************************************************/
+//Calc temperature and return it to the user
+//Returns 998 if I2C timed out
+//Returns 999 if CRC is wrong
+float HTU21D::readTemperature(void)
+{
+  triggerTemperature();
 
-  /* //Used for testing
-  byte msb, lsb, checksum;
-  msb = 0x4E;
-  lsb = 0x85;
-  checksum = 0x6B;*/
+  //Hang out while measurement is taken, 50mS max at 14 bit, page 3 of datasheet
+  float temperature;
+  while ((temperature = collectTemperature()) == HTU21D_NOTREADY)
+  {
+    delay(1);
+  }
+  return (temperature);
+}
 
-  unsigned int rawHumidity = ((unsigned int) msb << 8) | (unsigned int) lsb;
+//Non-blocking reads
+/*******************************************************************************************/
+//The no hold commands leave the bus free while the sensor measures, the sensor does not
+//acknowledge its address until the result is ready
+void HTU21D::triggerHumidity(void)
+{
+  _measureTime = measureTime(true);
+  trigger(TRIGGER_HUMD_MEASURE_NOHOLD);
+}
 
-  if (check_crc(rawHumidity, checksum) != 0) return (999); //Error out
+void HTU21D::triggerTemperature(void)
+{
+  _measureTime = measureTime(false);
+  trigger(TRIGGER_TEMP_MEASURE_NOHOLD);
+}
 
-  //sensorStatus = rawHumidity & 0x0003; //Grab only the right two bits
-  rawHumidity &= 0xFFFC; //Zero out the status bits but keep them in place
+//Returns 997 if the measurement is not finished yet
+//Returns 998 if I2C timed out
+//Returns 999 if CRC is wrong
+float HTU21D::collectHumidity(void)
+{
+  unsigned int rawHumidity;
+  int result = collect(&rawHumidity);
+  if (result != 0) return (result);
 
   //Given the raw humidity data, calculate the actual relative humidity
   float tempRH = rawHumidity / (float)65536; //2^16 = 65536
@@ -95,56 +117,74 @@ float HTU21D::readHumidity(void)
   return (rh);
 }
 
-//Read the temperature
-/*******************************************************************************************/
-//Calc temperature and return it to the user
+//Returns 997 if the measurement is not finished yet
 //Returns 998 if I2C timed out
 //Returns 999 if CRC is wrong
-float HTU21D::readTemperature(void)
+float HTU21D::collectTemperature(void)
+{
+  unsigned int rawTemperature;
+  int result = collect(&rawTemperature);
+  if (result != 0) return (result);
+
+  //Given the raw temperature data, calculate the actual temperature
+  float tempTemperature = rawTemperature / (float)65536; //2^16 = 65536
+  float realTemperature = (float)(-46.85 + (175.72 * tempTemperature)); //From page 14
+
+  return (realTemperature);
+}
+
+//Measurement time in ms at the current resolution, maximum values from page 3
+//        RH      Temp
+// 0/0    12 16   14 50
+// 0/1     8  3   12 13
+// 1/0    10  5   13 25
+// 1/1    11  8   11  7
+byte HTU21D::measureTime(bool humidity)
+{
+  switch (_resolution)
+  {
+    case B00000001: return (humidity ? 3 : 13);
+    case B10000000: return (humidity ? 5 : 25);
+    case B10000001: return (humidity ? 8 : 7);
+    default:        return (humidity ? 16 : 50);
+  }
+}
+
+void HTU21D::trigger(byte command)
 {
-  //Request the temperature
   Wire.beginTransmission(HTDU21D_ADDRESS);
-  Wire.write(TRIGGER_TEMP_MEASURE_NOHOLD);
+  Wire.write(command);
   Wire.endTransmission();
+  _triggered = millis();
+}
 
-  //Hang out while measurement is taken. 50mS max, page 4 of datasheet.
-  delay(55);
-
-  //Comes back in three bytes, data(MSB) / data(LSB) / Checksum
-  Wire.requestFrom(HTDU21D_ADDRESS, 3);
+//Read the three byte result, data(MSB) / data(LSB) / Checksum
+//Returns 0 and the raw value with the status bits cleared, or 997, 998 or 999
+int HTU21D::collect(unsigned int *raw)
+{
+  unsigned long elapsed = millis() - _triggered;
+  if (elapsed < _measureTime) return (HTU21D_NOTREADY); //Do not poll the bus before it can be ready
 
-  //Wait for data to become available
-  int counter = 0;
-  while (Wire.available() < 3)
+  if (Wire.requestFrom(HTDU21D_ADDRESS, 3) < 3)
   {
-    counter++;
-    delay(1);
-    if (counter > 100) return 998; //Error out
+    //Still measuring, or not there at all
+    if (elapsed > (unsigned long)_measureTime + HTU21D_TIMEOUT) return (998); //Error out
+    return (HTU21D_NOTREADY);
   }
 
-  unsigned char msb, lsb, checksum;
+  byte msb, lsb, checksum;
   msb = Wire.read();
   lsb = Wire.read();
   checksum = Wire.read();
 
-  /* //Used for testing
-  byte msb, lsb, checksum;
-  msb = 0x68;
-  lsb = 0x3A;
-  checksum = 0x7C; */
-
-  unsigned int rawTemperature = ((unsigned int) msb << 8) | (unsigned int) lsb;
+  *raw = ((unsigned int) msb << 8) | (unsigned int) lsb;
 
-  if (check_crc(rawTemperature, checksum) != 0) return (999); //Error out
+  if (check_crc(*raw, checksum) != 0) return (999); //Error out
 
-  //sensorStatus = rawTemperature & 0x0003; //Grab only the right two bits
-  rawTemperature &= 0xFFFC; //Zero out the status bits but keep them in place
+  //sensorStatus = *raw & 0x0003; //Grab only the right two bits
+  *raw &= 0xFFFC; //Zero out the status bits but keep them in place
 
-  //Given the raw temperature data, calculate the actual temperature
-  float tempTemperature = rawTemperature / (float)65536; //2^16 = 65536
-  float realTemperature = (float)(-46.85 + (175.72 * tempTemperature)); //From page 14
-
-  return (realTemperature);
+  return (0);
 }
 
 // Software Reset
@@ -153,6 +193,7 @@ void HTU21D::softReset(void)
   Wire.beginTransmission(HTDU21D_ADDRESS);
   Wire.write(SOFT_RESET);
   Wire.endTransmission();
+  _resolution = 0; //Reset puts the resolution back to the power on default
 }
 
 //Set sensor resolution
@@ -177,6 +218,7 @@ void HTU21D::setResolution(byte resolution)
   Wire.write(WRITE_USER_REG); //Write to the user register
   Wire.write(userRegister); //Write the new resolution bits
   Wire.endTransmission();
+  _resolution = resolution;
 }
 
 //Read the user register
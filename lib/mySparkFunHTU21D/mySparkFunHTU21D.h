@@ -29,6 +29,9 @@
 #define READ_USER_REG  0xE7
 #define SOFT_RESET  0xFE
 
+#define HTU21D_NOTREADY  997  //collect*() value while the sensor is still measuring
+#define HTU21D_TIMEOUT   100  //ms after the measurement time before collect*() gives up with 998
+
 class HTU21D {
 
 public:
@@ -41,6 +44,13 @@ public:
   void setResolution(byte resBits);
   void softReset(void);
 
+  //Non-blocking reads, trigger a measurement then collect it when measureTime() has passed
+  void triggerHumidity(void);
+  void triggerTemperature(void);
+  float collectHumidity(void);
+  float collectTemperature(void);
+  byte measureTime(bool humidity);
+
   //Public Variables
 
 private:
@@ -48,7 +58,12 @@ private:
 
   byte read_user_register(void);
   byte check_crc(uint16_t message_from_sensor, uint8_t check_value_from_sensor);
+  void trigger(byte command);
+  int collect(unsigned int *raw);
 
   //Private Variables
+  byte _resolution;                 //resolution bits last set, 0 after power on or reset
+  byte _measureTime;                //ms the triggered measurement takes at most
+  unsigned long _triggered;         //millis() when the measurement was triggered
 
 };
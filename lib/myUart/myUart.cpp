@@ -0,0 +1,153 @@
+// myUart.cpp
+// Interrupt driven USART0, see myUart.h
+
+#include <myUart.h>
+
+Uart uart;
+
+static void (*rxhandler)(char c, bool ok);
+static volatile char txbuf[UARTTXSIZE];
+static volatile uint8_t txhead;         // next free place in txbuf
+static volatile uint8_t txtail;         // next byte to send
+static uint16_t txstalls;               // print() calls that waited for room in the ring
+static uint8_t txpeak;                  // most bytes seen waiting in the ring
+
+static inline uint8_t txused()
+{
+  return (txhead - txtail) & (UARTTXSIZE - 1);
+}
+
+// count a wait before n bytes go in the ring
+static inline void txroom(size_t n)
+{
+  if ( (n > (size_t) (UARTTXSIZE - 1 - txused())) && (txstalls < 0xFFFF) )
+  {
+    txstalls++;
+  }
+}
+
+static inline void txsent()
+{
+  uint8_t used = txused();
+  if ( used > txpeak )
+  {
+    txpeak = used;
+  }
+}
+
+// move the next byte to the data register, stop the interrupt when there is none
+static inline void sendnext()
+{
+  if ( txhead == txtail )
+  {
+    UCSR0B &= ~_BV(UDRIE0);
+    return;
+  }
+  UDR0 = txbuf[txtail];
+  txtail = (txtail + 1) & (UARTTXSIZE - 1);
+}
+
+ISR(USART_RX_vect)
+{
+  bool frameerror = UCSR0A & _BV(FE0);
+  char c = UDR0;
+  rxhandler(c, !frameerror);
+}
+
+ISR(USART_UDRE_vect)
+{
+  sendnext();
+}
+
+// 8 data bits, no parity, 1 stop bit, the baud rate is set the way HardwareSerial does it
+void Uart::begin(unsigned long baud, void (*rx)(char c, bool ok))
+{
+  rxhandler = rx;
+  txhead = 0;
+  txtail = 0;
+  bool u2x = true;
+#if F_CPU == 16000000UL
+  if ( baud == 57600 )
+  {
+    u2x = false;                        // the rate the old bootloaders use, and closer at 16MHz
+  }
+#endif
+  uint16_t ubrr;
+  if ( u2x )
+  {
+    UCSR0A = _BV(U2X0);
+    ubrr = (F_CPU / 4 / baud - 1) / 2;
+  }
+  else
+  {
+    UCSR0A = 0;
+    ubrr = (F_CPU / 8 / baud - 1) / 2;
+  }
+  UBRR0H = ubrr >> 8;
+  UBRR0L = ubrr;
+  UCSR0C = _BV(UCSZ01) | _BV(UCSZ00);
+  UCSR0B = _BV(RXEN0) | _BV(TXEN0) | _BV(RXCIE0);
+}
+
+void Uart::write(char c)
+{
+  uint8_t next = (txhead + 1) & (UARTTXSIZE - 1);
+  while ( next == txtail )
+  {
+    if ( !(SREG & _BV(SREG_I)) && (UCSR0A & _BV(UDRE0)) )
+    {
+      sendnext();                       // interrupts are off, nothing else will empty the ring
+    }
+  }
+  txbuf[txhead] = c;
+  uint8_t sreg = SREG;                  // may be called with interrupts off
+  cli();
+  txhead = next;
+  UCSR0B |= _BV(UDRIE0);
+  SREG = sreg;
+}
+
+void Uart::print(const char *str)
+{
+  txroom(strlen(str));
+  while ( *str != 0 )
+  {
+    write(*str++);
+  }
+  txsent();
+}
+
+void Uart::print_P(PGM_P str)
+{
+  txroom(strlen_P(str));
+  char c;
+  while ( (c = pgm_read_byte(str++)) != 0 )
+  {
+    write(c);
+  }
+  txsent();
+}
+
+// wait until every byte in the ring has been sent
+void Uart::flush()
+{
+  while ( txhead != txtail )
+  {
+  }
+}
+
+uint16_t Uart::stalls()
+{
+  return txstalls;
+}
+
+uint8_t Uart::peak()
+{
+  return txpeak;
+}
+
+void Uart::clearstats()
+{
+  txstalls = 0;
+  txpeak = 0;
+}
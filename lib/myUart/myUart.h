@@ -0,0 +1,34 @@
+// myUart.h
+// Interrupt driven USART0 for the serial port, used instead of HardwareSerial.
+// Each received byte is handed to the function given to begin() from the RX
+// interrupt, so commands are framed as they arrive and do not wait in a receive
+// buffer for loop() to get round to them. ok is false for a byte with a framing
+// error. Nothing else may use Serial, as HardwareSerial would bring in its own
+// USART0 interrupt handlers.
+// Sent bytes go through a ring of UARTTXSIZE bytes emptied by the data register
+// empty interrupt, print() returns as soon as its text is in the ring. It only
+// waits when the ring is too full to take it, those waits are counted in stalls()
+// and the most bytes seen waiting in the ring is kept in peak().
+
+#ifndef UART_H
+#define UART_H
+
+#include <Arduino.h>
+
+#define UARTTXSIZE 64                   // bytes waiting to be sent, a power of 2
+
+class Uart {
+  public:
+    void begin(unsigned long baud, void (*rx)(char c, bool ok));
+    void write(char c);
+    void print(const char *str);
+    void print_P(PGM_P str);
+    void flush();
+    uint16_t stalls();
+    uint8_t peak();
+    void clearstats();
+};
+
+extern Uart uart;
+
+#endif
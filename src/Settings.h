@@ -30,10 +30,28 @@
 #define OLED_SCL          A5                      // connected to SCL pin on OLED
 #define TOGGLESWPIN       A0                      // Toggle switches wired to A0 via resistor divider network
 
-#define MAXCOMMAND        15                      // : + 2 + 10 + # = 14
-#define MAXPROBES         4                       // 9, 10, 11, or 12 bits, corresponding to increments of 0.5°C, 0.25°C, 0.125°C, and 0.0625°C, respectively
+#define MAXCOMMAND        24                      // : + 2 + 10 + # = 14, spare room paid for by strings moved to flash
+#define REPLYSIZE         48                      // longest reply sent in one piece, C with three temperatures and @65534, is 35
+#define MAXQUEUE          6                       // received commands waiting for processcmd(), at most 8
+#define MAXDEVICES        8                       // DS18B20 devices kept over all four probe buses
+#define MAXBINDINGS       6                       // DS18B20 ROM code to channel bindings kept in EEPROM
 #define TEMP_PRECISION    10                      // Set the DS18B20s precision, 10bit =0.25degrees, 12 = 0.06degrees 
+#define PROBEFARMARGIN    10.0                    // PROBEADAPTIVE, degrees above dew point for 9 bits
+#define PROBENEARMARGIN   7.0                     // PROBEADAPTIVE, degrees above dew point for 12 bits, covers the power band
+#define PROBEHYSTERESIS   1.0                     // PROBEADAPTIVE, degrees a channel must move back before it changes again
+// reading filters, median of TAPS readings (1 = off) then IIR moving 1/2^SHIFT of the way each reading (0 = off)
+#define PROBETAPS         3
+#define PROBESHIFT        1
+#define AMBIENTTAPS       3
+#define AMBIENTSHIFT      1
+#define HUMIDITYTAPS      5                       // DHT22 humidity noise moves the dew point by 1C
+#define HUMIDITYSHIFT     2
 #define EEPROMSIZE        1024                    // ATMEGA328P 1024 EEPROM - Nano v3
+#define EEPROMVALID       100                     // marks a good config record, changed whenever config_t changes
+#define MAXPROFILES       4                       // named configs kept at the top of EEPROM, fewer config records below them
+#define PROFILENAMESIZE   9                       // 8 characters and the 0
+#define IMAGEBUFFER       16                      // config image bytes from U waiting to be written to EEPROM, a power of 2
+#define IMAGENONE         0xFF                    // no config image being received by the U command
 #define NORMAL            1                       // mode of operation, changed by PB switches PB1 and PB2
 #define OVERRIDE          2                       // or serial commands n and 1, 2
 #define AMBIENT           1                       // constants for tracking mode algorithm, track ambient
@@ -46,8 +64,15 @@
 #define BUTTONDELAY       1000                    // Time between switch override checks
 #define BUF_SIZE          24                      // Size of buffer for OLED
 #define TEMPUPDATES       1000                    // Time in milliseconds of temperature updates
+#define TEMPSLOWUPDATES   4000                    // PROBEADAPTIVE, temperature updates while every channel is well clear
 #define MAXPAGETIME       5000
 #define MINPAGETIME       2000
+#define LCDCELLSPERPASS   8                       // LCD characters sent per pass of loop(), one I2C transaction
+#define MAXTASKS          9                       // size of the scheduler task table
+#define PROBETICK         10                      // ms between DS18B20 scratchpad reads
+#define PROBEMAXSKIPS     5                       // BLUETOOTH, ticks a read waits for a quiet softuart before it goes ahead
+#define HTUFASTMARGIN     9.0                     // HTUADAPTIVE, degrees above dew point for low resolution
+#define HTUPRECISEMARGIN  7.0                     // HTUADAPTIVE, back to full resolution below this
 
 // Power percentage levels
 #define POWER_0           0
@@ -56,29 +81,30 @@
 #define POWER_50          50
 #define POWER_75          75
 #define POWER_100         100
+#define FAILSAFEPOWER     POWER_50                // dew strap power while its probe or the ambient sensor has failed
 
-// 
-#define str0              "0"
-#define str50             "5"
-#define str75             "7"
-#define str100            "F"
-#define celstr            "C"       // Celsius
-#define fstr              "F"       // fahrenheit
-#define astr              "A"       // Ambient
-#define dstr              "D"       // dewpoint
-#define mstr              "M"       // midpoint
-#define offmsgstr         "OFF"
-#define onmsgstr          "ON"
-#define ch1msgstr         "CH1"
-#define ch2msgstr         "CH2"
-#define manstr            "MAN"     // manual
-#define probestr          "PROB"    // probe
-#define plusstr           "+"
-#define minusstr          "-"
-#define probesequals      "PROBES = "
-#define yesstr            "Y"
-#define nostr             "N"
-#define PCBprobeequalsstr "PCB PROBE = "
+// display strings, kept in flash by F() so only use them as print() arguments
+#define str0              F("0")
+#define str50             F("5")
+#define str75             F("7")
+#define str100            F("F")
+#define celstr            F("C")    // Celsius
+#define fstr              F("F")    // fahrenheit
+#define astr              F("A")    // Ambient
+#define dstr              F("D")    // dewpoint
+#define mstr              F("M")    // midpoint
+#define offmsgstr         F("OFF")
+#define onmsgstr          F("ON")
+#define ch1msgstr         F("CH1")
+#define ch2msgstr         F("CH2")
+#define manstr            F("MAN")  // manual
+#define probestr          F("PROB") // probe
+#define plusstr           F("+")
+#define minusstr          F("-")
+#define probesequals      F("PROBES = ")
+#define yesstr            F("Y")
+#define nostr             F("N")
+#define PCBprobeequalsstr F("PCB PROBE = ")
 
 
 #endif
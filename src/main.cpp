@@ -25,6 +25,9 @@
 // YOU MUST SET THESE DEFINES TO MATCH YOUR HARDWARE BEFORE COMPILING FIRMWARE
 // This single file supports the DHT and HTU21D sensors, the LCD and OLED displays, and Bluetooth
 // By default, the generated firmware is for LCD2004, DHT21 sensor, no bluetooth
+// The variant environments in platformio.ini define BUILDCONFIG and set these defines in
+// their build_flags instead, so this section is skipped for them
+#ifndef BUILDCONFIG
 
 // uncomment one of the following depending upon what sensor you are using
 #define DHTXX    1
@@ -39,11 +42,26 @@
 // uncomment the next line if you want BLUETOOTH
 #define BLUETOOTH 1
 
+// replies go back to the port the command came from, uncomment the next line to send them to
+// the serial port and bluetooth both, so a second program can follow what the first one is doing
+//#define MIRRORREPLIES 1
+
 // only uncomment one of the following depending upon your lcd type
 //#define LCD1602  1                    // 16 character, 2 lines
 //#define LCD1604  2                    // 16 character, 4 lines
 #define LCD2004  3                      // 20 character, 4 lines
 
+// uncomment the next line to record loop and function timing, read back with the X command
+//#define LOOPSTATS 1
+
+// comment out the next line to keep the DS18B20 probes at TEMP_PRECISION and read every TEMPUPDATES
+// otherwise probes well above the dew point use 9 bits and are read less often, probes close to it use 12 bits
+#define PROBEADAPTIVE 1
+
+// comment out the next line to keep the HTU21D at full resolution all the time
+// otherwise it uses the fast low resolution while every channel is well above the dew point
+#define HTUADAPTIVE 1
+
 #ifdef DHTXX                            // defines for each sensor type that is supported
 // you must uncomment only ONE of the following lines to match the DHT sensor you are using
 // if using a HTU21D sensor then leave MYSENSOR set to DHT22
@@ -52,75 +70,20 @@
 #define MYSENSOR DHT22
 //#define MYSENSOR DHT33
 #endif
+#endif // BUILDCONFIG
 
 // ==============================================================================================
 // DO NOT CHANGE ANYTHING IN THIS SECTION
-#ifndef DHTXX
-#ifndef HTU21DXX
-#halt //Error - you do not have a sensor type defined - define either DHTXX or HTU21D
-#endif
-#endif
-
-#ifdef DHTXX
-#ifndef MYSENSOR
-#halt //Error - you must set MYSENSOR to either DHT11, DHT21, DHT22 or DHT33 (even if you are using a HTU21D sensor
-#endif
-#endif
-
-// do not change
-#ifdef LCDDISPLAY
-#ifdef OLEDDISPLAY
-#halt //Error - you can only have one LCD type defined - either LCDDISPLAY or OLEDDISPLAY.
-#endif
-#endif
-
-// do not change
-#ifdef LCDDISPLAY
-#ifdef LCD1602
-#ifdef LCD1604
-#halt //Error - you can only have one LCD type defined, one of LCD1602, LCD1604 or LCD2004.
-#endif
-#endif
-#endif
-
-// do not change
-#ifdef LCDDISPLAY
-#ifdef LCD1602
-#ifdef LCD2004
-#halt //Error - you can only have one LCD type defined, one of LCD1602, LCD1604 or LCD2004.
-#endif
-#endif
-#endif
-
-// do not change
-#ifdef LCDDISPLAY
-#ifdef LCD1604
-#ifdef LCD2004
-#halt //Error - you can only have one LCD type defined, one of LCD1602, LCD1604 or LCD2004.
-#endif
-#endif
+#if defined(DHTXX) == defined(HTU21DXX)
+#error "define one sensor type, either DHTXX or HTU21DXX"
 #endif
 
-// do not change
-#ifdef LCDDISPLAY
-#ifdef LCD1602
-#ifdef LCD2004
-#ifdef LCD1604
-#halt //Error - you can only have one LCD type defined, one of LCD1602, LCD1604 or LCD2004.
-#endif
-#endif
-#endif
+#if defined(LCDDISPLAY) && defined(OLEDDISPLAY)
+#error "you can only have one display type, either LCDDISPLAY or OLEDDISPLAY"
 #endif
 
-// do not change
-#ifdef LCDDISPLAY
-#ifndef LCD2004
-#ifndef LCD1604
-#ifndef LCD1602
-#halt //Error - you can must define either LCD1602 or LCD2004 or LCD1604.
-#endif
-#endif
-#endif
+#if defined(LCDDISPLAY) && ((defined(LCD1602) + defined(LCD1604) + defined(LCD2004)) != 1)
+#error "define one LCD type, one of LCD1602, LCD1604 or LCD2004"
 #endif
 
 // do not change
@@ -129,6 +92,36 @@
 // ==============================================================================================
 // CHANGE REVISION SECTION START
 
+// 3.34
+// LCD pages are drawn into a shadow frame buffer and only changed characters are sent
+// LCD character runs are sent to the I2C expander in batched transactions
+// Display pages are sent a slice at a time from loop() so serial commands are not held up
+// OLED keeps a text shadow and only sends glyphs that changed
+// Display labels and protocol strings moved to flash
+// loop() runs a task table, the millis() timers are gone
+// Optional LOOPSTATS timing, X command returns it, x clears it
+// DHT bits are timed from the pin change interrupt instead of busy waiting, not with BLUETOOTH
+// HTU21D is triggered and collected by the scheduler, optional HTUADAPTIVE resolution
+// 1-Wire probe pins fixed at compile time, constant port bit timing
+// DS18B20 registry, several probes per bus and ROM code to channel bindings, O and P commands
+// DS18B20 conversions no longer block, scratchpads are read one per tick with CRC check and retry
+// Optional PROBEADAPTIVE probe resolution and read period from the dew point margin
+// Sensor health checks with last good hold, failed sensors degrade tracking, Q and q commands
+// Median and IIR filter on the probe, ambient and humidity readings
+// Commands run from a table in flash, replies built in a static buffer instead of String
+// Overlong commands are dropped up to their # instead of running into the next one
+// Own USART0 driver, commands framed from the RX interrupt straight into fixed slots
+// Bluetooth on a timer 2 software UART instead of SoftwareSerial, DHT read from its interrupt with BLUETOOTH too
+// Replies only go to the port the command came from, optional MIRRORREPLIES sends them to both
+// Replies are left in the transmit rings instead of waiting for them to be sent, X shows the waits for room
+// Optional @seq, command tags for pipelined commands, every tagged command is answered, ! when it was dropped as busy
+// Config image commands Y, U and u, a whole config is checked and saved in one step, EEPROM only writes changed bytes
+// Config image bytes are written to EEPROM one per pass while the EEPROM is ready, U and u wait in their slot for room
+// Named config profiles at the top of EEPROM, N saves, p switches, i lists, o picks the one used at boot
+// DHT edges out of their time window fail the reading, counted in the Q reply
+// DHT type picked by a template at compile time, display and bluetooth stay under #ifdef
+// Config checks reduced, platformio.ini has an env per variant
+
 // 3.33
 // Implement settings file
 
@@ -167,9 +160,15 @@
 // DO NOT CHANGE ANYTHING IN THIS SECTION
 
 #include <Arduino.h>
-#include <myQueue.h>                              //  By Steven de Salas
+#include <myUart.h>                               // USART0 driver, received bytes handed over from the interrupt
+#include <myCommandSlots.h>                       // received commands kept in fixed buffers until run
+#include <myScheduler.h>                          // task table run from loop()
+#ifdef LOOPSTATS
+#include <myLoopStats.h>                          // loop timing histogram
+#endif
 #include <Wire.h>                                 // needed for I2C
 #include <math.h>
+#include <util/crc16.h>                           // CRC of the config image
 #ifdef DHTXX
 #include <mydht.h>                                // needed for DHT11/21/22/33
 #endif
@@ -177,45 +176,74 @@
 #include <mySparkFunHTU21D.h>                     // needed for HTU21D sensor
 #endif
 #include <OneWire.h>                              // needed for DS18B20 temperature probe
+#include <myOneWirePin.h>                         // OneWire with the probe pin fixed at compile time
 #include <myDallasTemperature.h>                  // needed for DS18B20 temperature probe
+#include <myProbes.h>                             // DS18B20 devices on every bus and the channels they report to
+#include <myHealth.h>                             // plausibility checks and last good hold for each reading
+#include <myFilter.h>                             // median and IIR filter for each reading
 #include <myEEPROM.h>                             // needed for EEPROM v2.46 or higher
 #include <myeepromanything.h>                     // needed for EEPROM v2.46 or higher
 #ifdef BLUETOOTH
-#include <SoftwareSerial.h>                       // needed for BT adapter
+#include <mySoftUart.h>                           // BT adapter on a timer 2 software UART
 #endif
 #ifdef LCDDISPLAY
 #include <LCD.h>
 #include <LiquidCrystal_I2C.h>
+#include <myLCDBuffer.h>                          // shadow frame buffer, only changed cells are sent
 #endif
 #ifdef OLEDDISPLAY
 #include <mySSD1306Ascii.h>                       // oled
 #include <mySSD1306AsciiWire.h>                   // oled
+#include <myOLEDSlice.h>                          // sends one line of a page per pass of loop()
+#endif
+
+// labels and messages are kept in flash, print them with FPSTR() or F()
+#ifndef FPSTR
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper *>(p))
 #endif
 
 // ==============================================================================================
 // GLOBAL VARS - DO NOT CHANGE ANYTHING IN THIS SECTION
-char ver[] = "333";                               // do not change
-
-Queue<String> queue(10);                          // receive serial queue of commands
-char line[MAXCOMMAND];
-int eoc;                                          // end of command
-int idx;                                          // index into command string
+const char ver[] PROGMEM = "334";                 // do not change
+
+CommandSlots<MAXQUEUE, MAXCOMMAND> cmdslots;      // received commands waiting for processcmd()
+CommandFramer serialframer;                       // command being received on the serial port
+char reply[REPLYSIZE];                            // reply being built, sent by sendreply()
+uint8_t replylen;
+uint8_t replyport;                                // port the command being run came from
+bool replied;                                     // sendreply() has sent something since this was cleared
+bool cmdretry;                                    // set by a command that cannot run yet, it is run again next pass
+#define PORT_SERIAL       0
+#define PORT_BLUETOOTH    1
 int boardtemp;
-OneWire oneWirech1(CH1TEMP);                      // setup temperature probe 1
-OneWire oneWirech2(CH2TEMP);                      // setup temperature probe 2
-OneWire oneWirech3(CH3TEMP);                      // setup temperature probe 3
-OneWire oneWirefan(FANTEMP);                      // setup temperature for board - fan control
+OneWirePin<CH1TEMP> oneWirech1;                   // setup temperature probe 1
+OneWirePin<CH2TEMP> oneWirech2;                   // setup temperature probe 2
+OneWirePin<CH3TEMP> oneWirech3;                   // setup temperature probe 3
+OneWirePin<FANTEMP> oneWirefan;                   // setup temperature for board - fan control
 DallasTemperature sensor1(&oneWirech1);           // probe ch1
 DallasTemperature sensor2(&oneWirech2);           // probe ch2
 DallasTemperature sensor3(&oneWirech3);           // probe ch3
 DallasTemperature sensor4(&oneWirefan);           // probe fan
-DeviceAddress tpAddress;                          // used to send precision to specific sensor
+ProbeRegistry<4, MAXDEVICES> probes;              // every DS18B20 found, channel 1-3 dew straps, 4 board
+SensorHealth ch1health(-55, 125, 10);             // probe readings, range and largest step in C
+SensorHealth ch2health(-55, 125, 10);
+SensorHealth ch3health(-55, 125, 10);
+SensorHealth boardhealth(-55, 125, 20);
+SensorHealth ambienthealth(-40, 80, 10);          // DHT or HTU21D ambient temperature
+SensorHealth humidityhealth(0, 110, 30);          // DHT or HTU21D relative humidity, HTU21D reads over 100 in condensation
+MedianIIR<PROBETAPS> ch1filter(PROBESHIFT);       // filters after the health checks, see Settings.h
+MedianIIR<PROBETAPS> ch2filter(PROBESHIFT);
+MedianIIR<PROBETAPS> ch3filter(PROBESHIFT);
+MedianIIR<AMBIENTTAPS> ambientfilter(AMBIENTSHIFT);
+MedianIIR<HUMIDITYTAPS> humidityfilter(HUMIDITYSHIFT);
 int tprobe1;                                      // these indicate if there is a probe attached to that channel
 int tprobe2;
 int tprobe3;
 int tprobe4;
+#ifdef PROBEADAPTIVE
+uint8_t chbits[3] = { TEMP_PRECISION, TEMP_PRECISION, TEMP_PRECISION };  // probe resolution of ch1-ch3
+#endif
 bool displayenabled;                              // used to enable and disable the display
-long buttonLastChecked;                           // variable to limit the button getting checked every cycle
 int PBVal;                                        // holds state of toggle switch read
 float ch1tempval;                                 // temperature value for each probe
 float ch2tempval;
@@ -225,23 +253,50 @@ float ch2oldtempval;
 float ch3oldtempval;
 int ch1pwrval, ch2pwrval, ch3pwrval;              // percentage power to each channel
 int ch3manualpwrval;                              // used to remember the manualpwrsetting for ch3
-int hval;                                         // relative humidity
+float hval;                                       // relative humidity
 float tval;                                       // ambient temperature value
 float dew_point;                                  // dewpoint
 int ch1override, ch2override;                     // used in remote mode to override channels to 100%
 int computeroverride;                             // 1 if computer is overriding to 100% power for ch1 or ch2
 float TempF;                                      // used to hold conversion of temperatures to Fahrenheit
 long pos;                                         // holds any parameter sent with command
-long buttonchecktime;                             // time between switch override checks
 int currentaddr;                                  // will be address in eeprom of the data stored
+uint8_t imagelen = IMAGENONE;                     // config image bytes received by U, IMAGENONE when there is none
+uint16_t imagecrc;                                // CRC of the config image bytes received so far
+uint8_t imagewritten;                             // config image bytes written to EEPROM by imagetask()
+uint8_t imagebuf[IMAGEBUFFER];                    // config image bytes waiting for imagetask()
 bool writenow;                                    // should we update values in eeprom
-long currenttime;                                 // current timestamp
-long displaytimer;                                // time of last display update
-long temptimer;                                   // time of last temperature update
-bool temprefresh;
+bool temprefresh;                                 // true when a probe conversion has been started
+#ifdef BLUETOOTH
+uint8_t probeskips;                               // probetask() ticks in a row skipped for the softuart
+#endif
+Scheduler<MAXTASKS> scheduler;                    // task table, filled in by setup()
+uint8_t controltaskid;                            // control runs straight after each sensor read
+uint8_t sensortaskid;                             // sensor period follows the dew risk with PROBEADAPTIVE
+uint8_t displaytaskid;                            // display period follows dewconfig.displaytime
+#ifdef LOOPSTATS
+// sections timed by loopstats, one per display page after STATPAGE
+#define STATGETTEMPS      0                       // gettemps()
+#define STATSENSOR        1                       // updatedhtsensor(), the HTU21D is timed as htutask
+#define STATPROCESSCMD    2                       // processcmd()
+#define STATPAGE          3                       // display page 1, page n is STATPAGE + n - 1
+#define STATSECTIONS      8
+LoopStats<STATSECTIONS> loopstats;
+unsigned long statstart;                          // micros() at the start of the section being timed
+uint8_t statpage;                                 // display page being timed
+#define STATSTART()       statstart = micros()
+#define STATEND(id)       loopstats.record((id), micros() - statstart)
+#define STATPAGESTART(n)  statpage = (n); statstart = micros()
+#define STATPAGEEND()     loopstats.record(STATPAGE + statpage - 1, micros() - statstart)
+#else
+#define STATSTART()
+#define STATEND(id)
+#define STATPAGESTART(n)
+#define STATPAGEEND()
+#endif
 bool pcbfanon;
-String hash = "#";
-String endofstr = "$";
+const char hash = '#';                            // field separator in replies
+const char endofstr = '$';                        // end of reply
 
 // ==============================================================================================
 // EEPROM DATA STRUCT - DO NOT CHANGE ANYTHING IN THIS SECTION
@@ -263,15 +318,23 @@ struct config_t {
   // the values will be out of date. This time interval controls the refresh rate of updating the lcd displays
   // and calculating new values. Best for values between 2500 and 5000 (2.5s - 5s)
   int fantempoff;                       // the temperature at which the fan which be switched OFF
+  ProbeBinding probemap[MAXBINDINGS];   // DS18B20 ROM codes moved to another channel than their bus
 } dewconfig;
 
+// a named config saved by the N command, config.validdata is EEPROMVALID once it has been saved
+struct profile_t {
+  char name[PROFILENAMESIZE];
+  config_t config;
+};
+
+#define PROFILEADDR      (EEPROMSIZE - (MAXPROFILES * sizeof(profile_t)))   // profiles at the top of EEPROM
+#define BOOTPROFILEADDR  (PROFILEADDR - 1)        // profile loaded by setup(), anything else is the last config
+#define CONFIGAREA       BOOTPROFILEADDR          // config records wear levelled in the EEPROM below it
+
 // ==============================================================================================
 // CONDITIONAL DEFINES - DO NOT CHANGE ANYTHING IN THIS SECTION
 #ifdef BLUETOOTH
-SoftwareSerial btSerial( BTTX, BTRX);
-char btline[MAXCOMMAND];
-int bteoc;
-int btidx;
+CommandFramer btframer;                           // command being received over bluetooth
 #endif
 
 #ifdef LCDDISPLAY
@@ -285,18 +348,44 @@ int LCD1604Screen;
 int LCD2004Screen;                      // set the start page for the LC2004 display, 4 pages, 2.5s delay (controlled by interval)
 #endif
 LiquidCrystal_I2C lcd(LCDADDRESS, 2, 1, 0, 4, 5, 6, 7, 3, POSITIVE);
+#ifdef LCD1602
+LCDBuffer<16, 2> lcdframe(&lcd);        // pages are drawn here, then lcdframe.update() sends the changes
+#endif
+#ifdef LCD1604
+LCDBuffer<16, 4> lcdframe(&lcd);
+#endif
+#ifdef LCD2004
+LCDBuffer<20, 4> lcdframe(&lcd);
+#endif
 #endif
 
 #ifdef OLEDDISPLAY
 // Connect OLED VCC pin to 5V and OLED GND pin to GND
 SSD1306AsciiWire myoled;
+OLEDSlice oledslice(&myoled);           // pages are printed here, one line is sent to myoled per pass
 int DisplayPage;                        // set the start page for LCD1602 display
+int OLEDRenderPage;                     // page being sent to the display
+uint8_t OLEDRenderLine;                 // next line of that page to send, displayRows() when done
 #endif
 
 #ifdef DHTXX
 dht mydht;                              // setup dhtxx sensor
 int dhtchk;                             // variable to hold result of reading sensor
 bool dhterrorflag;                      // state of DHTxx sensor read, true = Error, false = OK
+
+// start signal for the DHT set by MYSENSOR, chosen when compiling instead of tested on every
+// read, a MYSENSOR that is not one of the DHT types does not compile
+// the DHT is always read in the background from the pin change interrupt on DHTDATA
+template<uint8_t SENSOR> struct DhtSensor {
+  static_assert((SENSOR == DHT21) || (SENSOR == DHT22) || (SENSOR == DHT33), "MYSENSOR must be DHT11, DHT21, DHT22 or DHT33");
+  static void start() { mydht.start( DHTDATA ); }
+};
+
+template<> struct DhtSensor<DHT11> {    // the DHT11 needs the longer start signal
+  static void start() { mydht.start11( DHTDATA ); }
+};
+
+typedef DhtSensor<MYSENSOR> mysensor;
 #endif
 
 #ifdef HTU21DXX                         // define HTU21D sensor and variables
@@ -313,78 +402,83 @@ const byte rh10t13 = B10000000;         // 25ms
 const byte rh11t11 = B10000001;         // 8ms
 byte myHTU21DResolution = rh12t14;      // resolution set to highest
 const float TempCoefficient = -0.15;    // The temperature compensation coefficient value to ensure RH accuracy between 20-80%RH
+// a reading is triggered by starthtusensor() and collected by htutask(), temperature then humidity
+#define HTU_IDLE          0
+#define HTU_TEMPERATURE   1
+#define HTU_HUMIDITY      2
+byte htustate = HTU_IDLE;               // measurement the sensor is working on
 #endif
 
 #ifdef LCDDISPLAY
 #ifdef LCD1602
-char atstr[]    = "AT:";
-char hustr[]    = "HU :";
-char atbstr[]   = "ATB:";
-char dpstr[]    = "DP:";
-char c1str[]    = "C1:";
-char c2str[]    = "C2:";
-char c3str[]    = "C3:";
-char p1str[]    = "P1:";
-char p2str[]    = "P2:";
-char p3str[]    = "P3:";
-char tmstr[]    = "TM  :";
-char tmostr[]   = "TMO :";
-char fsstr[]    = "FS  :";
-char pcbtstr[]  = "PCBT:";
-char pcbsstr[]  = "PCBS:";
-char pcbsstroff[]  = "PCBO:";
-char ch3mstr[]  = "CH3M:";
-char dashstr[]  = "--";
+const char atstr[]    PROGMEM = "AT:";
+const char hustr[]    PROGMEM = "HU :";
+const char atbstr[]   PROGMEM = "ATB:";
+const char dpstr[]    PROGMEM = "DP:";
+const char c1str[]    PROGMEM = "C1:";
+const char c2str[]    PROGMEM = "C2:";
+const char c3str[]    PROGMEM = "C3:";
+const char p1str[]    PROGMEM = "P1:";
+const char p2str[]    PROGMEM = "P2:";
+const char p3str[]    PROGMEM = "P3:";
+const char tmstr[]    PROGMEM = "TM  :";
+const char tmostr[]   PROGMEM = "TMO :";
+const char fsstr[]    PROGMEM = "FS  :";
+const char pcbtstr[]  PROGMEM = "PCBT:";
+const char pcbsstr[]  PROGMEM = "PCBS:";
+const char pcbsstroff[]  PROGMEM = "PCBO:";
+const char ch3mstr[]  PROGMEM = "CH3M:";
+const char dashstr[]  PROGMEM = "--";
 #endif
 #ifdef LCD1604
-char atstr[]    = "AT:";
-char hustr[]    = "HU :";
-char atbstr[]   = "ATB:";
-char dpstr[]    = "DP:";
-char c1str[]    = "C1:";
-char c2str[]    = "C2:";
-char c3str[]    = "C3:";
-char p1str4[]   = "P1 :";
-char p2str4[]   = "P2 :";
-char p3str[]    = "P3 :";
-char tmstr[]    = "TM  :";
-char tmostr[]   = "TMO:";
-char ch3mstr[]  = "CH3M:";
-char fsstr[]    = "FS:";
-char pcbtstr[]  = "PCBT:";
-char pcbsstr[]  = "PCBS:";
-char pcbsstroff[]  = "PCBO:";
-char dashstr[]  = "--";
+const char atstr[]    PROGMEM = "AT:";
+const char hustr[]    PROGMEM = "HU :";
+const char atbstr[]   PROGMEM = "ATB:";
+const char dpstr[]    PROGMEM = "DP:";
+const char c1str[]    PROGMEM = "C1:";
+const char c2str[]    PROGMEM = "C2:";
+const char c3str[]    PROGMEM = "C3:";
+const char p1str4[]   PROGMEM = "P1 :";
+const char p2str4[]   PROGMEM = "P2 :";
+const char p3str[]    PROGMEM = "P3 :";
+const char tmstr[]    PROGMEM = "TM  :";
+const char tmostr[]   PROGMEM = "TMO:";
+const char ch3mstr[]  PROGMEM = "CH3M:";
+const char fsstr[]    PROGMEM = "FS:";
+const char pcbtstr[]  PROGMEM = "PCBT:";
+const char pcbsstr[]  PROGMEM = "PCBS:";
+const char pcbsstroff[]  PROGMEM = "PCBO:";
+const char dashstr[]  PROGMEM = "--";
 #endif
 #ifdef LCD2004
-char pcbtempstr[]         = "PCBTemp  = ";
-char pcbtempsetpointstr[] = "PCBTarg  = ";
-char fanspeedstr[]        = "Fanspeed = ";
-char tmoffsetstr[]        = "TMOffset   = ";
-char atstr1[]     = "AMBIENT TEMP= ";
-char atbiasstr1[] = "AT Bias     = ";
-char hustr1[]     = "REL HUMIDITY= ";
-char dpstr1[]     = "DEW POINT   = ";
-char tmstr1[]     = "TRACKING = ";        // tacking mode
-char ch1str[]     = "CH1 ";
-char ch2str[]     = "CH2 ";
-char ch3str[]     = "CH3 ";
-char tmpstr[]     = "TEMP = ";
-char pwrstr[]     = "PWR  = ";
-char modestr[]    = "MODE = ";
-char fspeedstr1[] = "FAN SPEED= ";
-char offstr[]     = "OFFSET = ";
-char dashstr[]  = "--";
-char pcbtstr[]  = "PCBT:";
-char pcbsstr[]  = "PCBS:";
-char pcbsstroff[]  = "PCBO:";
+const char pcbtempstr[]         PROGMEM = "PCBTemp  = ";
+const char pcbtempsetpointstr[] PROGMEM = "PCBTarg  = ";
+const char fanspeedstr[]        PROGMEM = "Fanspeed = ";
+const char tmoffsetstr[]        PROGMEM = "TMOffset   = ";
+const char atstr1[]     PROGMEM = "AMBIENT TEMP= ";
+const char atbiasstr1[] PROGMEM = "AT Bias     = ";
+const char hustr1[]     PROGMEM = "REL HUMIDITY= ";
+const char dpstr1[]     PROGMEM = "DEW POINT   = ";
+const char tmstr1[]     PROGMEM = "TRACKING = ";   // tacking mode
+const char ch1str[]     PROGMEM = "CH1 ";
+const char ch2str[]     PROGMEM = "CH2 ";
+const char ch3str[]     PROGMEM = "CH3 ";
+const char tmpstr[]     PROGMEM = "TEMP = ";
+const char pwrstr[]     PROGMEM = "PWR  = ";
+const char modestr[]    PROGMEM = "MODE = ";
+const char fspeedstr1[] PROGMEM = "FAN SPEED= ";
+const char offstr[]     PROGMEM = "OFFSET = ";
+const char dashstr[]  PROGMEM = "--";
+const char pcbtstr[]  PROGMEM = "PCBT:";
+const char pcbsstr[]  PROGMEM = "PCBS:";
+const char pcbsstroff[]  PROGMEM = "PCBO:";
 #endif
 #endif
 
 #ifdef OLEDDISPLAY
-char programName1[]   = "myDCP3";      // Program title and version information
-char programAuthor[]  = "(C) R BROWN 2017";
-char dashstr[]  = "--";
+const char programName1[]   PROGMEM = "myDCP3";      // Program title and version information
+const char programAuthor[]  PROGMEM = "(C) R BROWN 2017";
+const char dashstr[]  PROGMEM = "--";
 #endif
 
 // ==============================================================================================
@@ -395,18 +489,167 @@ void writeconfig()
   EEPROM_writeAnything(currentaddr, dewconfig);    // update values in EEPROM
 }
 
-void sendresponsestr(String str)
+// send the reply built so far to the port the command came from, then empty it
+void sendreply()
 {
-  if (Serial)
+#ifndef MIRRORREPLIES
+  if ( replyport == PORT_SERIAL )
+#endif
   {
-    Serial.print(str);
+    uart.print(reply);
   }
 #ifdef BLUETOOTH
+#ifndef MIRRORREPLIES
+  if ( replyport == PORT_BLUETOOTH )
+#endif
   {
-    btSerial.print(str);
+    softuart.print(reply);
   }
 #endif
+  replylen = 0;
+  reply[0] = 0;
+  replied = true;
+}
+
+// add text to the reply, anything past REPLYSIZE is dropped
+void replytext(const char *str)
+{
+  while ( (*str != 0) && (replylen < (REPLYSIZE - 1)) )
+  {
+    reply[replylen++] = *str++;
+  }
+  reply[replylen] = 0;
+}
+
+void replytext_P(PGM_P str)
+{
+  char c;
+  while ( ((c = pgm_read_byte(str++)) != 0) && (replylen < (REPLYSIZE - 1)) )
+  {
+    reply[replylen++] = c;
+  }
+  reply[replylen] = 0;
+}
+
+void replychar(char c)
+{
+  char str[2] = { c, 0 };
+  replytext(str);
+}
+
+void replyint(long val)
+{
+  char str[12];
+  replytext(ltoa(val, str, 10));
+}
+
+void replyulong(unsigned long val)
+{
+  char str[12];
+  replytext(ultoa(val, str, 10));
+}
+
+// two hex digits, as in a ROM code
+void replyhex(uint8_t val)
+{
+  char str[3];
+  if ( val < 16 )
+  {
+    replychar('0');
+  }
+  replytext(itoa(val, str, 16));
+}
+
+// same digits as String(val, digits)
+void replyfloat(float val, uint8_t digits)
+{
+  char str[33];
+  replytext(dtostrf(val, digits + 2, digits, str));
+}
+
+// end the reply with $ and send it
+void replyend()
+{
+  replychar(endofstr);
+  sendreply();
+}
+
+// start the reply to a tagged command with @seq,
+void replytag(uint16_t seq)
+{
+  replychar('@');
+  replyulong(seq);
+  replychar(',');
+}
+
+// a reply of one int, such as T2$
+void replyvalue(char cmd, long val)
+{
+  replychar(cmd);
+  replyint(val);
+  replyend();
+}
+
+#ifdef LOOPSTATS
+// reply to the X command, fields are separated by #, times are in microseconds
+// Xpasses#longestpass#bucket0#...#bucket7#
+//   then for each section in STAT order, longest#mean#
+//   then for each scheduler task in table order, worstlate(ms)#longestrun#misses#
+//   then overruns#queuefull# the commands dropped as too long or with the queue full,
+//   then serialstalls#serialpeak#btstalls#btpeak# the replies that waited for room in each transmit
+//   ring and the most bytes seen waiting in it, bluetooth is 0#0# without BLUETOOTH, and $ at the end
+void sendloopstats()
+{
+  replychar('X');
+  replyulong(loopstats.passes());
+  replychar(hash);
+  replyulong(loopstats.loopmax());
+  replychar(hash);
+  sendreply();
+  for ( uint8_t b = 0; b < LOOPBUCKETS; b++ )
+  {
+    replyulong(loopstats.bucket(b));
+    replychar(hash);
+    sendreply();
+  }
+  for ( uint8_t id = 0; id < STATSECTIONS; id++ )
+  {
+    replyulong(loopstats.maxtime(id));
+    replychar(hash);
+    replyulong(loopstats.meantime(id));
+    replychar(hash);
+    sendreply();
+  }
+  for ( uint8_t id = 0; id < scheduler.count(); id++ )
+  {
+    const Task &t = scheduler.task(id);
+    replyulong(t.maxlate);
+    replychar(hash);
+    replyulong(t.maxtime);
+    replychar(hash);
+    replyulong(t.misses);
+    replychar(hash);
+    sendreply();
+  }
+  replyulong(cmdslots.overruns());
+  replychar(hash);
+  replyulong(cmdslots.dropped());
+  replychar(hash);
+  replyulong(uart.stalls());
+  replychar(hash);
+  replyulong(uart.peak());
+  replychar(hash);
+#ifdef BLUETOOTH
+  replyulong(softuart.stalls());
+  replychar(hash);
+  replyulong(softuart.peak());
+  replychar(hash);
+#else
+  replytext_P(PSTR("0#0#"));
+#endif
+  replyend();
 }
+#endif
 
 void updatefanmotor()
 {
@@ -440,6 +683,21 @@ void updatefanmotor()
   }
 }
 
+// tracking mode in use, falls back to AMBIENT when the humidity reading has failed
+// and to 0, no tracking, when the ambient temperature has failed
+int trackingmode()
+{
+  if ( ambienthealth.failed() )
+  {
+    return 0;
+  }
+  if ( humidityhealth.failed() )
+  {
+    return AMBIENT;
+  }
+  return dewconfig.TrackingState;
+}
+
 int getpwr( float channeltemp, int trackmode )
 {
   int pwrlevel = POWER_0;
@@ -528,7 +786,7 @@ void seteepromdefaults()
 {
   // set defaults because not found
   // data was erased so write some default values
-  dewconfig.validdata = 99;
+  dewconfig.validdata = EEPROMVALID;
   dewconfig.TrackingState = DEWPOINT;
   dewconfig.offsetval = 0;
   dewconfig.fanspeed = 0;
@@ -541,6 +799,7 @@ void seteepromdefaults()
   dewconfig.shadowch = 0;
   dewconfig.displaytime = 2500;         // allows user to set how long each page is displayed for
   dewconfig.DisplayMode = CELSIUS;
+  memset(dewconfig.probemap, 0, sizeof(dewconfig.probemap));
   updatefanmotor();
   writeconfig();                        // update values in EEPROM
 }
@@ -556,494 +815,969 @@ float calc_dewpoint(float t, float h)
   return dew_point;
 }
 
-// process commands
-void processcmd( )
+// set the probe indicators, a channel has a probe if any device reports to it
+void updateprobeflags()
 {
-  int len;
-  String replystr = "";
-  char mycmd;
-  String param = "";
+  tprobe1 = (probes.devices(1) > 0) ? 1 : 0;
+  tprobe2 = (probes.devices(2) > 0) ? 1 : 0;
+  tprobe3 = (probes.devices(3) > 0) ? 1 : 0;
+  tprobe4 = (probes.devices(4) > 0) ? 1 : 0;
+}
 
-  replystr = queue.pop();
-  len = replystr.length();
-  if ( len == 2 )
+// move the devices named in the config to their channels
+void applyprobemap()
+{
+  probes.unbind();
+  for ( uint8_t i = 0; i < MAXBINDINGS; i++ )
   {
-    mycmd = replystr.charAt(0);         // a valid command with no parameters, ie, 1#
+    if ( dewconfig.probemap[i].rom[0] != 0 )
+    {
+      probes.bind(dewconfig.probemap[i].rom, dewconfig.probemap[i].channel);
+    }
   }
-  else if ( len > 2 )
+  updateprobeflags();
+}
+
+// reply to the O command, for each device found in scan order
+// Orom#bus#channel#...$ where rom is 16 hex digits and bus 1-4 is CH1TEMP, CH2TEMP, CH3TEMP, FANTEMP
+void sendprobemap()
+{
+  replychar('O');
+  sendreply();
+  for ( uint8_t id = 0; id < probes.count(); id++ )
   {
-    mycmd = replystr.charAt(0);         // this command has parameters
-    param = replystr.substring(1, len - 1);
+    const ProbeDevice &d = probes.device(id);
+    for ( uint8_t i = 0; i < sizeof(DeviceAddress); i++ )
+    {
+      replyhex(d.rom[i]);
+    }
+    replychar(hash);
+    replyint(d.bus + 1);
+    replychar(hash);
+    replyint(d.channel);
+    replychar(hash);
+    sendreply();
   }
-  else return;
-
-#ifdef DEBUG
-  Serial.print("replystr = "); Serial.println(replystr);
-  Serial.print("len = "); Serial.println(len);
-  Serial.print("mycmd = "); Serial.println(mycmd);
-  Serial.print("param = "); Serial.println(param);
-#endif
+  replyend();
+}
 
-  switch ( mycmd )
+// P command, Pdevice,channel# binds the device at that place in the O reply to a channel
+// 0 leaves the device unused, P# clears every binding
+void setprobemap(const char *param)
+{
+  if ( *param == 0 )
   {
-    case 'v':       // v get version number
-      replystr = "v" + String(ver) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case '?':       // ? get the ch1offset and ch2offset and ch3offset values
-      replystr = "?" + String(dewconfig.ch1offset) + hash + String(dewconfig.ch2offset) + hash + String(dewconfig.ch3offset) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'E':      // E Returns which dewstrap channel the 3rd Dewstrap is shadowing (0-none, 1=channel1, 2=channel2, 3=manual, 4=tempprobe3)
-      // then ch3 pwr and then ch3 temp
-      replystr = "E" + String(dewconfig.shadowch) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'g':      // g return the number of temperature probes
-      {
-        int nprobes = tprobe1 + tprobe2 + tprobe3;
-        replystr = "g" + String(nprobes) + endofstr;
-        sendresponsestr(replystr);
-      }
-      break;
-    case 'T':      // T return tracking mode
-      replystr = "T" + String(dewconfig.TrackingState) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'F':      // F return fanspeed
-      if ( dewconfig.fantempon > 0 )
+    memset(dewconfig.probemap, 0, sizeof(dewconfig.probemap));
+  }
+  else
+  {
+    const char *comma = strchr(param, ',');
+    if ( (comma == NULL) || (comma == param) )
+    {
+      return;
+    }
+    int id = atoi(param);
+    int channel = atoi(comma + 1);
+    if ( (id < 0) || (id >= probes.count()) || (channel < 0) || (channel > 4) )
+    {
+      return;
+    }
+    const ProbeDevice &d = probes.device(id);
+    int slot = -1;
+    for ( uint8_t i = 0; i < MAXBINDINGS; i++ )
+    {
+      if ( memcmp(dewconfig.probemap[i].rom, d.rom, sizeof(DeviceAddress)) == 0 )
       {
-        if ( boardtemp >= dewconfig.fantempon )
-        {
-          replystr = "F100" + endofstr;
-          sendresponsestr(replystr);
-        }
-        else
-        {
-          replystr = "F0" + endofstr;
-          sendresponsestr(replystr);
-        }
+        slot = i;                       // already bound, replace it
+        break;
       }
-      else
+      if ( (slot < 0) && (dewconfig.probemap[i].rom[0] == 0) )
       {
-        replystr = "F" + String(dewconfig.fanspeed) + endofstr;
-        sendresponsestr(replystr);
+        slot = i;                       // first free entry
       }
+    }
+    if ( slot < 0 )
+    {
+      return;                           // no room left for another binding
+    }
+    memcpy(dewconfig.probemap[slot].rom, d.rom, sizeof(DeviceAddress));
+    dewconfig.probemap[slot].channel = channel;
+  }
+  imagelen = IMAGENONE;                 // a config image being received is for the old config
+  applyprobemap();
+  writeconfig();
+}
+
+// The config image is the bytes of config_t, so a host can save a whole config with Y and
+// put it back with U and u, instead of sending each setting with its own command and each
+// one rewriting the config. U writes the image straight into the next EEPROM record with
+// validdata left 0, so it needs no RAM, and u checks it and makes it the current record.
+// The old record is only given up once the new one is complete, so a reset at any point
+// leaves one whole config, never a half applied one.
+
+// address of the record after the current one, where a config image is received
+int nextconfigaddr()
+{
+  int addr = currentaddr + sizeof(config_t);
+  if ( (addr + sizeof(config_t)) > CONFIGAREA )
+  {
+    addr = 0;
+  }
+  return addr;
+}
+
+// every value in a config image is one the commands could have set
+bool configvalid(const config_t &c)
+{
+  if ( (c.TrackingState < 0) || (c.TrackingState > 3) || (c.offsetval < OFFSETNEGLIMIT) || (c.offsetval > OFFSETPOSLIMIT) ||
+       (c.fanspeed < 0) || (c.fanspeed > POWER_100) || (c.fantempon < 0) || (c.fantempon > POWER_100) ||
+       (c.fantempoff < -2) || (c.fantempoff > 100) || (c.ATBias < -4) || (c.ATBias > 3) ||
+       (c.shadowch < 0) || (c.shadowch > 7) || ((c.DisplayMode != CELSIUS) && (c.DisplayMode != FAHRENHEIT)) ||
+       (c.displaytime < MINPAGETIME) || (c.displaytime > MAXPAGETIME) ||
+       !isfinite(c.ch1offset) || !isfinite(c.ch2offset) || !isfinite(c.ch3offset) )
+  {
+    return false;
+  }
+  for ( uint8_t i = 0; i < MAXBINDINGS; i++ )
+  {
+    if ( c.probemap[i].channel > 4 )
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+// reply to the Y command, Yversion#size#image#crc$
+// version is EEPROMVALID, size the bytes in config_t, image two hex digits for each of
+// those bytes and crc the CRC-16 (_crc16_update() from 0xFFFF) of the bytes, in decimal
+void sendconfigimage()
+{
+  const uint8_t *image = (const uint8_t *) &dewconfig;
+  uint16_t crc = 0xFFFF;
+  replychar('Y');
+  replyint(EEPROMVALID);
+  replychar(hash);
+  replyint(sizeof(config_t));
+  replychar(hash);
+  sendreply();
+  for ( uint8_t i = 0; i < sizeof(config_t); i++ )
+  {
+    replyhex(image[i]);
+    crc = _crc16_update(crc, image[i]);
+    if ( (i % 16) == 15 )
+    {
+      sendreply();
+    }
+  }
+  replychar(hash);
+  replyulong(crc);
+  replyend();
+}
+
+// U command, Uoffset,hex# puts the bytes in hex, two digits each, into the config image at offset
+// offset 0 starts a new image, after that each part must carry on where the last one ended
+// a part out of order, a bad digit or an image for another version drops the image until offset 0
+// the bytes wait in imagebuf for imagetask(), a part that does not fit yet is run again next pass
+void receiveconfigimage(const char *param)
+{
+  const char *hex = strchr(param, ',');
+  int offset = atoi(param);
+  bool ok = (hex != NULL) && (hex != param) && ((offset == 0) || ((imagelen != IMAGENONE) && (offset == imagelen)));
+  const int version = EEPROMVALID;
+  uint8_t part[MAXCOMMAND / 2];
+  uint8_t n = 0;
+  char digits[3] = { 0, 0, 0 };
+  for ( hex = ok ? hex + 1 : ""; (hex[0] != 0) && (hex[1] != 0); hex += 2 )
+  {
+    digits[0] = hex[0];
+    digits[1] = hex[1];
+    char *end;
+    uint8_t val = strtoul(digits, &end, 16);
+    uint8_t at = offset + n;
+    if ( (end != (digits + 2)) || (at >= sizeof(config_t)) ||
+         ((at < sizeof(int)) && (val != ((const uint8_t *) &version)[at])) )
+    {
+      ok = false;
       break;
-    case 'A':      // A return ambient temperature in Celsius
-      replystr = "A";
+    }
+    part[n++] = val;
+  }
+  if ( !ok )
+  {
+    imagelen = IMAGENONE;
+    return;
+  }
+  if ( offset == 0 )
+  {
+    imagelen = 0;
+    imagewritten = 0;
+    imagecrc = 0xFFFF;
+  }
+  if ( (imagelen - imagewritten + n) > IMAGEBUFFER )
+  {
+    cmdretry = true;                    // imagetask() has not made room yet
+    return;
+  }
+  for ( uint8_t i = 0; i < n; i++ )
+  {
+    imagecrc = _crc16_update(imagecrc, part[i]);
+    // validdata stays 0 until u has checked the image
+    imagebuf[imagelen % IMAGEBUFFER] = (imagelen < sizeof(int)) ? 0 : part[i];
+    imagelen++;
+  }
+}
+
+// write the next config image byte from U into the next config record, only when the EEPROM
+// has finished the last one, so the 3.3ms each byte takes never holds up the loop
+void imagetask()
+{
+  if ( (imagelen != IMAGENONE) && (imagewritten < imagelen) && eeprom_is_ready() )
+  {
+    EEPROM.update(nextconfigaddr() + imagewritten, imagebuf[imagewritten % IMAGEBUFFER]);
+    imagewritten++;
+  }
+}
+
+// make the record at addr, written with validdata 0, the current one and c the config
+// the new record is marked valid before the old one is given up
+void takeconfig(int addr, config_t &c)
+{
+  imagelen = IMAGENONE;                 // any image being received was going to addr too
+  c.validdata = EEPROMVALID;
+  EEPROM_writeAnything(addr, c.validdata);
+  int erased = 0;
+  EEPROM_writeAnything(currentaddr, erased);
+  currentaddr = addr;
+  dewconfig = c;
+  updatefanmotor();
+  applyprobemap();
+}
+
+// u command, ucrc# checks the image U received and makes it the config, crc as in the Y reply
+// replies u1$ when the config was changed, u0$ when the image was short, had the wrong crc
+// or a value out of range, and the config was left as it was
+// it is run again next pass until imagetask() has written the whole image
+// returns true when the config was changed
+bool applyconfigimage(const char *param)
+{
+  if ( (imagelen == sizeof(config_t)) && (imagewritten < imagelen) )
+  {
+    cmdretry = true;
+    return false;
+  }
+  bool ok = (imagelen == sizeof(config_t)) && ((uint16_t) atol(param) == imagecrc);
+  imagelen = IMAGENONE;
+  if ( ok )
+  {
+    config_t image;
+    int addr = nextconfigaddr();
+    EEPROM_readAnything(addr, image);
+    image.validdata = EEPROMVALID;
+    ok = configvalid(image);
+    if ( ok )
+    {
+      takeconfig(addr, image);
+    }
+  }
+  replyvalue('u', ok ? 1 : 0);
+  return ok;
+}
+
+// Profiles are named configs kept in MAXPROFILES places above the config records. Switching
+// to one goes through the next config record the same way as u, so it is applied whole
+// and saved once, and the control task uses it from its next run.
+
+int profileaddr(uint8_t n)
+{
+  return PROFILEADDR + (n * sizeof(profile_t));
+}
+
+// read profile n, false if n is out of range or nothing valid was saved there
+bool readprofile(int n, profile_t &profile)
+{
+  if ( (n < 0) || (n >= MAXPROFILES) )
+  {
+    return false;
+  }
+  EEPROM_readAnything(profileaddr(n), profile);
+  profile.name[PROFILENAMESIZE - 1] = 0;
+  return (profile.config.validdata == EEPROMVALID) && configvalid(profile.config);
+}
+
+// N command, Nn,name# saves the config as profile n, name is up to 8 letters, digits, - or _
+void saveprofile(const char *param)
+{
+  const char *name = strchr(param, ',');
+  int n = atoi(param);
+  if ( (name == NULL) || (name == param) || (n < 0) || (n >= MAXPROFILES) )
+  {
+    return;
+  }
+  profile_t profile;
+  memset(&profile, 0, sizeof(profile));
+  for ( uint8_t i = 0; name[i + 1] != 0; i++ )
+  {
+    char c = name[i + 1];
+    if ( (i >= (PROFILENAMESIZE - 1)) || !(isalnum(c) || (c == '-') || (c == '_')) )
+    {
+      return;
+    }
+    profile.name[i] = c;
+  }
+  profile.config = dewconfig;
+  EEPROM_writeAnything(profileaddr(n), profile);
+}
+
+// p command, pn# makes profile n the config, replies p1$ when it was changed, p0$ when there is no profile n
+// returns true when the config was changed
+bool switchprofile(const char *param)
+{
+  profile_t profile;
+  bool ok = readprofile(atoi(param), profile);
+  if ( ok )
+  {
+    int addr = nextconfigaddr();
+    profile.config.validdata = 0;
+    EEPROM_writeAnything(addr, profile.config);
+    takeconfig(addr, profile.config);
+  }
+  replyvalue('p', ok ? 1 : 0);
+  return ok;
+}
+
+// reply to the i command, iboot#name0#name1#...$ boot is the profile setup() loads, -1 for
+// the last config, and each name is empty where no profile has been saved
+void sendprofiles()
+{
+  profile_t profile;
+  uint8_t boot = EEPROM.read(BOOTPROFILEADDR);
+  replychar('i');
+  replyint(readprofile(boot, profile) ? boot : -1);
+  replychar(hash);
+  sendreply();
+  for ( uint8_t n = 0; n < MAXPROFILES; n++ )
+  {
+    if ( readprofile(n, profile) )
+    {
+      replytext(profile.name);
+    }
+    replychar(hash);
+  }
+  replyend();
+}
+
+// o command, on# has setup() load profile n, o-1# or any n without a profile keeps the last config
+void setbootprofile(const char *param)
+{
+  profile_t profile;
+  int n = atoi(param);
+  EEPROM.update(BOOTPROFILEADDR, readprofile(n, profile) ? n : 0xFF);
+}
+
+// reply to the Q command, fields are separated by #
+// Qtracking#readerrors# tracking is the mode in use, 0 when the ambient has failed,
+// readerrors counts DS18B20 scratchpads that failed the CRC or held the power on value
+//   then for ch1, ch2, ch3, board, ambient, humidity in that order, state#faults#rejects#
+//   state 0=ok 1=holding last good 2=failed 3=stuck
+//   then badframes# the DHT readings dropped for an edge out of time, 0 with HTU21DXX, and $ at the end
+void sendhealth()
+{
+  SensorHealth *sensors[6] = { &ch1health, &ch2health, &ch3health, &boardhealth, &ambienthealth, &humidityhealth };
+  replychar('Q');
+  replyint(trackingmode());
+  replychar(hash);
+  replyulong(probes.readerrors());
+  replychar(hash);
+  sendreply();
+  for ( uint8_t i = 0; i < 6; i++ )
+  {
+    replyint(sensors[i]->state());
+    replychar(hash);
+    replyulong(sensors[i]->faults());
+    replychar(hash);
+    replyulong(sensors[i]->rejects());
+    replychar(hash);
+    sendreply();
+  }
 #ifdef DHTXX
-      if ( dhterrorflag == true )
-#endif
-#ifdef HTU21DXX
-        if ( tval_error == true )
+  replyulong(mydht.badframes());
+#else
+  replychar('0');
 #endif
-        {
-          replystr = replystr + "0.0";
-        }
-        else
-        {
-          replystr = replystr + String(tval, 3);
-        }
-      replystr = replystr  + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'R':      // R return relative Humidity
-      replystr = "R";
+  replychar(hash);
+  replyend();
+}
+
+// command handlers, param is the text between the command character and the #
+
+void cmdversion(const char *param)                // v get version number
+{
+  replychar('v');
+  replytext_P(ver);
+  replyend();
+}
+
+void cmdoffsets(const char *param)                // ? get the ch1offset and ch2offset and ch3offset values
+{
+  replychar('?');
+  replyfloat(dewconfig.ch1offset, 2);
+  replychar(hash);
+  replyfloat(dewconfig.ch2offset, 2);
+  replychar(hash);
+  replyfloat(dewconfig.ch3offset, 2);
+  replyend();
+}
+
+void cmdprobecount(const char *param)             // g return the number of temperature probes
+{
+  replyvalue('g', tprobe1 + tprobe2 + tprobe3);
+}
+
+void cmdfanspeed(const char *param)               // F return fanspeed, 0 or 100 under temperature control
+{
+  if ( dewconfig.fantempon > 0 )
+  {
+    replyvalue('F', (boardtemp >= dewconfig.fantempon) ? 100 : 0);
+  }
+  else
+  {
+    replyvalue('F', dewconfig.fanspeed);
+  }
+}
+
+void cmdambient(const char *param)                // A return ambient temperature in Celsius
+{
+  replychar('A');
 #ifdef DHTXX
-      if ( dhterrorflag == true )
+  if ( dhterrorflag == true )
 #endif
 #ifdef HTU21DXX
-        if ( hval_error == true )
+  if ( tval_error == true )
 #endif
-        {
-          replystr = replystr + "0";
-        }
-        else
-        {
+  {
+    replytext_P(PSTR("0.0"));
+  }
+  else
+  {
+    replyfloat(tval, 3);
+  }
+  replyend();
+}
+
+void cmdhumidity(const char *param)               // R return relative Humidity
+{
+  replychar('R');
 #ifdef DHTXX
-          replystr = replystr + String((float)hval, 2);
+  if ( dhterrorflag == true )
 #endif
 #ifdef HTU21DXX
-          replystr = replystr + String(hval_comp, 2);       // two decimal places
+  if ( hval_error == true )
 #endif
-        }
-      replystr = replystr + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'D':      // D return dewpoint temperature in Celsius
-      replystr = "D";
+  {
+    replychar('0');
+  }
+  else
+  {
 #ifdef DHTXX
-      if ( dhterrorflag == true )
+    replyfloat(hval, 2);
 #endif
 #ifdef HTU21DXX
-        if ( dp_error == true )
+    replyfloat(hval_comp, 2);                     // two decimal places
 #endif
-        {
-          replystr = replystr + "0.0";
-        }
-        else
-        {
-          replystr = replystr + String(dew_point, 3);
-        }
-      replystr = replystr + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'C':      // C return ch1/ch2/ch3 temperature in Celsius
-      replystr = "C" + String(ch1tempval, 3) + hash + String(ch2tempval, 3) + hash + String(ch3tempval, 3)  + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'W':      // W return ch1/ch2/ch3 power settings
-      replystr = "W" + String(ch1pwrval) + hash + String(ch2pwrval) + hash + String(ch3pwrval) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'B':      // B return AT Bias
-      replystr = "B" + String(dewconfig.ATBias) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'H':      // - Returns the lcddisplaytime
-      replystr = "H" + String(dewconfig.displaytime) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case  '1':
-      if ( tprobe1 == 1 )               // only overrride if there is a probe
-      {
-        ch1override = 1;
-        ch1pwrval = POWER_100;
-        computeroverride = 1;
-      }
-      break;
-    case '2':
-      if ( tprobe2 == 1 )               // only overrride if there is a probe
-      {
-        ch2override = 1;
-        ch2pwrval = POWER_100;
-        computeroverride = 1;
-      }
-      break;
-    case 'n':      // "n" switch to normal mode
-      ch1override = 0;
-      ch2override = 0;
-      computeroverride = 0;
-      break;
-    case 'a':      // set tracking mode
-      {
-        // get tracking mode value as next parameter
-        // extract the value from the command string
-        dewconfig.TrackingState = param.toInt() & 0x03;
-        writeconfig();
-      }
-      break;
-    case 'h':      // get DisplayMode C or F
-      replystr = "h" + String(dewconfig.DisplayMode) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'c':      // "c" display in Celcius
-      dewconfig.DisplayMode = CELSIUS;
-      writeconfig();
-      break;
-    case 'f':      // "f" display in Fahrenheit
-      dewconfig.DisplayMode = FAHRENHEIT;
-      writeconfig();
-      break;
-    case '<':      // "<" decrease offset
-      dewconfig.offsetval = dewconfig.offsetval - 1;
-      if ( dewconfig.offsetval <= OFFSETNEGLIMIT )
-      {
-        dewconfig.offsetval = OFFSETNEGLIMIT;
-      }
-      writeconfig();
-      break;
-    case '>':      // " > " increase offset
-      dewconfig.offsetval = dewconfig.offsetval + 1;
-      if ( dewconfig.offsetval >= OFFSETPOSLIMIT )
-      {
-        dewconfig.offsetval = OFFSETPOSLIMIT;
-      }
-      writeconfig();
-      break;
-    case 'z':      // "z" zero offset
-      dewconfig.offsetval = 0;
-      writeconfig();
-      break;
-    case 'y':     // get tracking mode offset value
-      replystr = "y" + String(dewconfig.offsetval) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 's':     // set fan speed
-      {
-        // get the next parameters
-        // extract the value from the command string
-        int fspeed = param.toInt();
-        if ( fspeed < 0)
-        {
-          fspeed = 0;
-        }
-        if ( fspeed >= 100 )
-        {
-          fspeed = POWER_100;
-        }
-        dewconfig.fanspeed = fspeed;
-        updatefanmotor();
-        writeconfig();
-      }
-      break;
-    case 'I':      // set fan temp control
-      {
-        // get the next parameters
-        // extract the value from the command string
-        int ftemp = param.toInt();
-        if ( ftemp < 0)
-        {
-          ftemp = 0;
-        }
-        if ( ftemp >= 100 )
-        {
-          ftemp = POWER_100;
-        }
-        dewconfig.fantempon = ftemp;
-        if ( ftemp == 0 )
-        {
-          dewconfig.fanspeed = POWER_0;
-          updatefanmotor();
-        }
-        writeconfig();
-      }
-      break;
-    case 'J':      // J return fantemp setting at which fan turns on
-      replystr = "J" + String( dewconfig.fantempon ) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'K':      // K return board temperature
-      replystr = "K" + String( boardtemp ) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'L':      // J return fantemp setting at which fan turns off
-      replystr = "L" + String( dewconfig.fantempoff ) + endofstr;
-      sendresponsestr(replystr);
-      break;
-    case 'M':      // set fan temp off
-      {
-        // get the next parameters
-        // extract the value from the command string
-        int ftemp = param.toInt();
-        if ( ftemp < 0)
-        {
-          ftemp = 0;
-        }
-        if ( ftemp > 100 )
-        {
-          ftemp = 100;
-        }
-        if ( ftemp >= dewconfig.fantempon )
-        {
-          ftemp = dewconfig.fantempon - 2;
-        }
-        dewconfig.fantempoff = ftemp;
-        writeconfig();
-      }
-      break;
-    case 'e':      // set atbias
-      {
-        // get the next parameters
-        // extract the value from the command string
-        int biasnum = param.toInt();
-        if ( biasnum < -4)
-        {
-          biasnum = -4;
-        }
-        if ( biasnum > 3)
-        {
-          biasnum = 3;
-        }
-        dewconfig.ATBias = biasnum;
-        writeconfig();
-      }
-      break;
-    case 'w':      // w write variables back to EEPROM
-      writeconfig();
-      break;
-    case '[':      // [ set the ch1offset value
-      // extract the value from the command string
-      // convert to float;
-      dewconfig.ch1offset = param.toFloat();
-      writeconfig();
-      break;
-    case ']':      // ] set the ch2offset value
-      // convert to float;
-      dewconfig.ch2offset = param.toFloat();
-      writeconfig();
-      break;
-    case '%':      // % set the ch3offset value
-      // convert to float;
-      dewconfig.ch3offset = param.toFloat();
-      writeconfig();
-      break;
-    case '&':      // & clear ch1offset and ch2offset and ch3offset to 0.0
-      dewconfig.ch1offset = 0.0;
-      dewconfig.ch2offset = 0.0;
-      dewconfig.ch3offset = 0.0;
-      writeconfig();
-      break;
-    case '{':      // { turn off display
+  }
+  replyend();
+}
+
+void cmddewpoint(const char *param)               // D return dewpoint temperature in Celsius
+{
+  replychar('D');
+#ifdef DHTXX
+  if ( dhterrorflag == true )
+#endif
+#ifdef HTU21DXX
+  if ( dp_error == true )
+#endif
+  {
+    replytext_P(PSTR("0.0"));
+  }
+  else
+  {
+    replyfloat(dew_point, 3);
+  }
+  replyend();
+}
+
+void cmdtemps(const char *param)                  // C return ch1/ch2/ch3 temperature in Celsius
+{
+  replychar('C');
+  replyfloat(ch1tempval, 3);
+  replychar(hash);
+  replyfloat(ch2tempval, 3);
+  replychar(hash);
+  replyfloat(ch3tempval, 3);
+  replyend();
+}
+
+void cmdpower(const char *param)                  // W return ch1/ch2/ch3 power settings
+{
+  replychar('W');
+  replyint(ch1pwrval);
+  replychar(hash);
+  replyint(ch2pwrval);
+  replychar(hash);
+  replyint(ch3pwrval);
+  replyend();
+}
+
+void cmdoverride1(const char *param)              // 1 override ch1 to 100%
+{
+  if ( tprobe1 == 1 )                             // only overrride if there is a probe
+  {
+    ch1override = 1;
+    ch1pwrval = POWER_100;
+    computeroverride = 1;
+  }
+}
+
+void cmdoverride2(const char *param)              // 2 override ch2 to 100%
+{
+  if ( tprobe2 == 1 )                             // only overrride if there is a probe
+  {
+    ch2override = 1;
+    ch2pwrval = POWER_100;
+    computeroverride = 1;
+  }
+}
+
+void cmdnormal(const char *param)                 // n switch to normal mode
+{
+  ch1override = 0;
+  ch2override = 0;
+  computeroverride = 0;
+}
+
+void cmdfanspeedset(const char *param)            // after s, set fan speed
+{
+  updatefanmotor();
+}
+
+void cmdfantemponset(const char *param)           // after I, 0 turns fan temp control off
+{
+  if ( dewconfig.fantempon == 0 )
+  {
+    dewconfig.fanspeed = POWER_0;
+    updatefanmotor();
+  }
+}
+
+void cmdfantempoffset(const char *param)          // after M, the fan goes off below where it goes on
+{
+  if ( dewconfig.fantempoff >= dewconfig.fantempon )
+  {
+    dewconfig.fantempoff = dewconfig.fantempon - 2;
+  }
+}
+
+void cmdclearoffsets(const char *param)           // & clear ch1offset and ch2offset and ch3offset to 0.0
+{
+  dewconfig.ch1offset = 0.0;
+  dewconfig.ch2offset = 0.0;
+  dewconfig.ch3offset = 0.0;
+}
+
+void cmddisplayoff(const char *param)             // { turn off display
+{
 #ifdef LCDDISPLAY
-      lcd.noDisplay();
-      lcd.noBacklight();
+  lcd.noDisplay();
+  lcd.noBacklight();
 #endif
 #ifdef OLEDDISPLAY
-      myoled.Display_Off();
+  myoled.Display_Off();
 #endif
-      displayenabled = false;
-      break;
-    case '}':      // } turn on display
+  displayenabled = false;
+}
+
+void cmddisplayon(const char *param)              // } turn on display
+{
 #ifdef LCDDISPLAY
-      lcd.display();
-      lcd.backlight();
+  lcd.display();
+  lcd.backlight();
 #endif
 #ifdef OLEDDISPLAY
-      myoled.Display_On();
+  myoled.Display_On();
 #endif
-      displayenabled = true;
+  displayenabled = true;
+}
+
+void cmdshadowset(const char *param)              // after S, 0 = off, 1=dewstrap1, 2=dewstrap3, 3=manual, 4=tempprobe3
+{
+  switch ( dewconfig.shadowch )
+  {
+    case 0:                                       // off
+      ch3pwrval = 0;
+      ch3tempval = 0.0;
       break;
-    case 'S':     // set how ch3 will behave
-      {
-        // set shadow dewstrap, 0 = off, 1=dewstrap1, 2=dewstrap3, 3=manual, 4=tempprobe3
-        dewconfig.shadowch = param.toInt() & 0x07;
-        switch ( dewconfig.shadowch)
-        {
-          case 0:                       // off
-            ch3pwrval = 0;
-            ch3tempval = 0.0;
-            break;
-          case 1:                       // ch1
-            ch3pwrval = ch1pwrval;
-            ch3tempval = ch1tempval;
-            break;
-          case 2:                       // ch2
-            ch3pwrval = ch2pwrval;
-            ch3tempval = ch2tempval;
-            break;
-          case 3:                       // manual
-            // and save the pwrval for later recall
-            ch3tempval = 0.0;           // temp not used for manual mode
-            ch3pwrval = ch3manualpwrval;
-            break;
-          case 4:                       // use temp probe
-            break;
-        }
-        writeconfig();
-      }
+    case 1:                                       // ch1
+      ch3pwrval = ch1pwrval;
+      ch3tempval = ch1tempval;
       break;
-    case 'G':     // 3rd dew channel set to manual mode
-      {
-        dewconfig.shadowch = 3;         // set to manual
-        // set ch3pwrval
-        int shadowval;
-        shadowval = param.toInt();
-        // shadowval is a percentage 0 to 100, when sent to dewstrap it is multiplied by 2.54
-        if ( shadowval < 0 )
-        {
-          shadowval = 0;
-        }
-        if ( shadowval >= 100)
-        {
-          shadowval = 100;
-        }
-        ch3tempval = 0.0;               // temp not used in manual mode
-        ch3pwrval = shadowval;
-        ch3manualpwrval = shadowval;    // save for later recall if mode is switched
-        writeconfig();
-      }
+    case 2:                                       // ch2
+      ch3pwrval = ch2pwrval;
+      ch3tempval = ch2tempval;
       break;
-    case 'b':     // set the displaytime bNum# where num is in milliseconds with range from 2500 t0 5000
-      {
-        int temptime;
-        temptime = param.toInt();
-        if ( temptime < MINPAGETIME )
-        {
-          temptime = MINPAGETIME;
-        }
-        if ( temptime > MAXPAGETIME)
-        {
-          temptime = MAXPAGETIME;
-        }
-        dewconfig.displaytime = temptime;
-        writeconfig();
-      }
+    case 3:                                       // manual, use the saved pwrval
+      ch3tempval = 0.0;                           // temp not used for manual mode
+      ch3pwrval = ch3manualpwrval;
       break;
-    case 'r':
-      seteepromdefaults();
+    case 4:                                       // use temp probe
       break;
-      // any more commands place here
   }
-  Serial.flush();                    // ensure serial buffer is empty
-#ifdef BLUETOOTH
-  btSerial.flush();
+}
+
+void cmdconfigimage(const char *param)            // Y return the config image
+{
+  sendconfigimage();
+}
+
+void cmdconfigpart(const char *param)             // U receive part of a config image
+{
+  receiveconfigimage(param);
+}
+
+void cmdconfigapply(const char *param)            // u check the config image and make it the config
+{
+  if ( applyconfigimage(param) )
+  {
+    cmdshadowset(param);
+  }
+}
+
+void cmdprofilesave(const char *param)            // N save the config as a named profile
+{
+  saveprofile(param);
+}
+
+void cmdprofileswitch(const char *param)          // p switch to a saved profile
+{
+  if ( switchprofile(param) )
+  {
+    cmdshadowset(param);
+  }
+}
+
+void cmdprofiles(const char *param)               // i return the boot profile and the profile names
+{
+  sendprofiles();
+}
+
+void cmdbootprofile(const char *param)            // o set the profile loaded at boot
+{
+  setbootprofile(param);
+}
+
+void cmdmanualset(const char *param)              // after G, 3rd dew channel set to manual mode
+{
+  dewconfig.shadowch = 3;                         // set to manual
+  ch3tempval = 0.0;                               // temp not used in manual mode
+  ch3pwrval = ch3manualpwrval;                    // percentage 0 to 100, when sent to dewstrap it is multiplied by 2.54
+}
+
+void cmddefaults(const char *param)               // r reset the config to defaults
+{
+  imagelen = IMAGENONE;
+  seteepromdefaults();
+  applyprobemap();
+}
+
+void cmdprobemap(const char *param)               // O return the DS18B20 devices found and their channels
+{
+  sendprobemap();
+}
+
+void cmdbindprobe(const char *param)              // P bind a DS18B20 device to a channel
+{
+  setprobemap(param);
+}
+
+void cmdhealth(const char *param)                 // Q return sensor health and fault counters
+{
+  sendhealth();
+}
+
+void cmdclearhealth(const char *param)            // q clear sensor fault counters
+{
+  ch1health.clear();
+  ch2health.clear();
+  ch3health.clear();
+  boardhealth.clear();
+  ambienthealth.clear();
+  humidityhealth.clear();
+  probes.clearerrors();
+#ifdef DHTXX
+  mydht.clearbadframes();
 #endif
 }
 
+#ifdef LOOPSTATS
+void cmdloopstats(const char *param)              // X return loop timing statistics
+{
+  sendloopstats();
+}
+
+void cmdclearloopstats(const char *param)         // x clear loop timing statistics
+{
+  loopstats.reset();
+  scheduler.resetstats();
+  cmdslots.clearcounts();
+  uart.clearstats();
 #ifdef BLUETOOTH
-void clearbtPort()
+  softuart.clearstats();
+#endif
+}
+#endif
+
+// what processcmd() does with the value of a command
+#define CMD_GET       0                           // reply with the int value
+#define CMD_SET       1                           // int value = parameter limited to lo..hi
+#define CMD_MASK      2                           // int value = parameter & hi
+#define CMD_CONST     3                           // int value = lo
+#define CMD_DOWN      4                           // int value - 1, not below lo
+#define CMD_UP        5                           // int value + 1, not above hi
+#define CMD_FLOAT     6                           // float value = parameter
+#define CMD_RUN       7                           // nothing, fn does the work
+#define CMD_SAVE      0x80                        // write the config afterwards
+
+// one entry per command, fn is called after the value is changed, NULL if there is nothing more to do
+struct command_t {
+  char cmd;
+  uint8_t type;
+  int lo;
+  int hi;
+  void *value;
+  void (*fn)(const char *param);
+};
+
+const command_t commands[] PROGMEM = {
+  { 'v', CMD_RUN, 0, 0, NULL, cmdversion },
+  { '?', CMD_RUN, 0, 0, NULL, cmdoffsets },
+  { 'E', CMD_GET, 0, 0, &dewconfig.shadowch, NULL },     // 0-none, 1=channel1, 2=channel2, 3=manual, 4=tempprobe3
+  { 'g', CMD_RUN, 0, 0, NULL, cmdprobecount },
+  { 'T', CMD_GET, 0, 0, &dewconfig.TrackingState, NULL },
+  { 'F', CMD_RUN, 0, 0, NULL, cmdfanspeed },
+  { 'A', CMD_RUN, 0, 0, NULL, cmdambient },
+  { 'R', CMD_RUN, 0, 0, NULL, cmdhumidity },
+  { 'D', CMD_RUN, 0, 0, NULL, cmddewpoint },
+  { 'C', CMD_RUN, 0, 0, NULL, cmdtemps },
+  { 'W', CMD_RUN, 0, 0, NULL, cmdpower },
+  { 'B', CMD_GET, 0, 0, &dewconfig.ATBias, NULL },
+  { 'H', CMD_GET, 0, 0, &dewconfig.displaytime, NULL },
+  { '1', CMD_RUN, 0, 0, NULL, cmdoverride1 },
+  { '2', CMD_RUN, 0, 0, NULL, cmdoverride2 },
+  { 'n', CMD_RUN, 0, 0, NULL, cmdnormal },
+  { 'a', CMD_MASK | CMD_SAVE, 0, 0x03, &dewconfig.TrackingState, NULL },
+  { 'h', CMD_GET, 0, 0, &dewconfig.DisplayMode, NULL },
+  { 'c', CMD_CONST | CMD_SAVE, CELSIUS, 0, &dewconfig.DisplayMode, NULL },
+  { 'f', CMD_CONST | CMD_SAVE, FAHRENHEIT, 0, &dewconfig.DisplayMode, NULL },
+  { '<', CMD_DOWN | CMD_SAVE, OFFSETNEGLIMIT, 0, &dewconfig.offsetval, NULL },
+  { '>', CMD_UP | CMD_SAVE, 0, OFFSETPOSLIMIT, &dewconfig.offsetval, NULL },
+  { 'z', CMD_CONST | CMD_SAVE, 0, 0, &dewconfig.offsetval, NULL },
+  { 'y', CMD_GET, 0, 0, &dewconfig.offsetval, NULL },
+  { 's', CMD_SET | CMD_SAVE, 0, POWER_100, &dewconfig.fanspeed, cmdfanspeedset },
+  { 'I', CMD_SET | CMD_SAVE, 0, POWER_100, &dewconfig.fantempon, cmdfantemponset },
+  { 'J', CMD_GET, 0, 0, &dewconfig.fantempon, NULL },
+  { 'K', CMD_GET, 0, 0, &boardtemp, NULL },
+  { 'L', CMD_GET, 0, 0, &dewconfig.fantempoff, NULL },
+  { 'M', CMD_SET | CMD_SAVE, 0, 100, &dewconfig.fantempoff, cmdfantempoffset },
+  { 'e', CMD_SET | CMD_SAVE, -4, 3, &dewconfig.ATBias, NULL },
+  { 'w', CMD_RUN | CMD_SAVE, 0, 0, NULL, NULL },
+  { '[', CMD_FLOAT | CMD_SAVE, 0, 0, &dewconfig.ch1offset, NULL },
+  { ']', CMD_FLOAT | CMD_SAVE, 0, 0, &dewconfig.ch2offset, NULL },
+  { '%', CMD_FLOAT | CMD_SAVE, 0, 0, &dewconfig.ch3offset, NULL },
+  { '&', CMD_RUN | CMD_SAVE, 0, 0, NULL, cmdclearoffsets },
+  { '{', CMD_RUN, 0, 0, NULL, cmddisplayoff },
+  { '}', CMD_RUN, 0, 0, NULL, cmddisplayon },
+  { 'S', CMD_MASK | CMD_SAVE, 0, 0x07, &dewconfig.shadowch, cmdshadowset },
+  { 'G', CMD_SET | CMD_SAVE, 0, 100, &ch3manualpwrval, cmdmanualset },
+  { 'b', CMD_SET | CMD_SAVE, MINPAGETIME, MAXPAGETIME, &dewconfig.displaytime, NULL },
+  { 'r', CMD_RUN, 0, 0, NULL, cmddefaults },
+  { 'O', CMD_RUN, 0, 0, NULL, cmdprobemap },
+  { 'P', CMD_RUN, 0, 0, NULL, cmdbindprobe },
+  { 'Q', CMD_RUN, 0, 0, NULL, cmdhealth },
+  { 'q', CMD_RUN, 0, 0, NULL, cmdclearhealth },
+  { 'Y', CMD_RUN, 0, 0, NULL, cmdconfigimage },
+  { 'U', CMD_RUN, 0, 0, NULL, cmdconfigpart },
+  { 'u', CMD_RUN, 0, 0, NULL, cmdconfigapply },
+  { 'N', CMD_RUN, 0, 0, NULL, cmdprofilesave },
+  { 'p', CMD_RUN, 0, 0, NULL, cmdprofileswitch },
+  { 'i', CMD_RUN, 0, 0, NULL, cmdprofiles },
+  { 'o', CMD_RUN, 0, 0, NULL, cmdbootprofile },
+#ifdef LOOPSTATS
+  { 'X', CMD_RUN, 0, 0, NULL, cmdloopstats },
+  { 'x', CMD_RUN, 0, 0, NULL, cmdclearloopstats },
+#endif
+  // any more commands place here
+};
+#define NUMCOMMANDS (sizeof(commands) / sizeof(command_t))
+
+// run one command, the command character is looked up in commands[] and its entry is copied out of flash
+// returns false for an unknown command
+bool runcmd(char mycmd, const char *param)
 {
-  while (btSerial.available())
+  for ( uint8_t i = 0; i < NUMCOMMANDS; i++ )
   {
-    btSerial.read();
+    if ( (char) pgm_read_byte(&commands[i].cmd) == mycmd )
+    {
+      command_t c;
+      memcpy_P(&c, &commands[i], sizeof(command_t));
+      int *value = (int *) c.value;
+      switch ( c.type & ~CMD_SAVE )
+      {
+        case CMD_GET:
+          replyvalue(mycmd, *value);
+          break;
+        case CMD_SET:
+          {
+            int val = (int) atol(param);
+            *value = constrain(val, c.lo, c.hi);
+          }
+          break;
+        case CMD_MASK:
+          *value = (int) atol(param) & c.hi;
+          break;
+        case CMD_CONST:
+          *value = c.lo;
+          break;
+        case CMD_DOWN:
+          *value = (*value - 1 <= c.lo) ? c.lo : *value - 1;
+          break;
+        case CMD_UP:
+          *value = (*value + 1 >= c.hi) ? c.hi : *value + 1;
+          break;
+        case CMD_FLOAT:
+          *(float *) c.value = atof(param);
+          break;
+      }
+      if ( c.fn != NULL )
+      {
+        c.fn(param);
+      }
+      if ( c.type & CMD_SAVE )
+      {
+        imagelen = IMAGENONE;                     // a config image being received is for the old config
+        writeconfig();
+      }
+      return true;
+    }
   }
+  return false;
 }
 
-void btSerialEvent()
+// process the oldest received command, it is read in its slot and the slot freed afterwards
+// a command may be tagged with a sequence number 0-65534, @seq,command# such as @12,s50#, so the
+// host can send several without waiting. The reply to a tagged command starts with @seq, and
+// a tagged command with no reply of its own is answered @seq,command$ once it has been run,
+// @seq,*$ if it is not known. A command dropped with every slot in use is answered !$, or
+// @seq,!$ if it was tagged, by commstask(). A tag that is not 1-5 digits below 65535 followed
+// by a comma and a command is answered @seq,*$, or *$ when the number itself is not valid.
+// A command that sets cmdretry cannot run yet, it stays in its slot, unanswered, and is run
+// again on the next pass, so the commands after it wait and keep their order.
+void processcmd( )
 {
-  while (btSerial.available() && !bteoc )
+  char *cmdline = cmdslots.next();
+  if ( cmdline == NULL )
   {
-    char btinChar = btSerial.read();
-    btline[btidx++] = btinChar;
-    if (btidx >= MAXCOMMAND)
+    return;
+  }
+  uint16_t seq = SEQ_NONE;
+  if ( cmdline[0] == '@' )
+  {
+    uint8_t i = 1;
+    seq = 0;
+    while ( isdigit(cmdline[i]) && (i <= SEQ_DIGITS) )
     {
-      btidx = MAXCOMMAND - 1;
+      seq = seqdigit(seq, cmdline[i++]);
     }
-    if (btinChar == '#')
+    if ( (i == 1) || isdigit(cmdline[i]) )
     {
-      bteoc = 1;
-      btidx = 0;
-      queue.push(String(btline));
-      bteoc = 0;
-      memset( btline, 0, MAXCOMMAND);
+      seq = SEQ_NONE;                             // no digits or too many
     }
+    if ( (seq == SEQ_NONE) || (cmdline[i] != ',') || (strlen(cmdline + i + 1) < 2) )
+    {
+      replyport = cmdslots.port();                // a bad tag, or no command after it
+      if ( seq != SEQ_NONE )
+      {
+        replytag(seq);
+      }
+      replychar('*');
+      replyend();
+      cmdslots.release();
+      return;
+    }
+    cmdline += i + 1;
   }
-}
+  uint8_t len = strlen(cmdline);
+  if ( len >= 2 )
+  {
+    char mycmd = cmdline[0];
+    cmdline[len - 1] = 0;                         // drop the #
+    const char *param = cmdline + 1;              // empty for a command with no parameters, ie, 1#
+#ifdef DEBUG
+    uart.print_P(PSTR("mycmd = ")); uart.write(mycmd); uart.print_P(PSTR("\r\n"));
+    uart.print_P(PSTR("param = ")); uart.print(param); uart.print_P(PSTR("\r\n"));
 #endif
+    replyport = cmdslots.port();
+    replied = false;
+    if ( seq != SEQ_NONE )
+    {
+      replytag(seq);                              // goes in front of the first part of the reply
+    }
+    bool known = runcmd(mycmd, param);
+    if ( cmdretry )
+    {
+      cmdretry = false;
+      cmdline[len - 1] = '#';                     // as it was received
+      replylen = 0;                               // drop the tag
+      reply[0] = 0;
+      return;
+    }
+    if ( (seq != SEQ_NONE) && !replied )
+    {
+      replychar(known ? mycmd : '*');
+      replyend();
+    }
+  }
+  cmdslots.release();                           // the reply is left to the transmit interrupts
+}
 
-void clearSerialPort()
+// called from the USART0 receive interrupt with each byte
+// : starts the command, # ends the command, whole commands are queued in cmdslots
+void serialrx(char c, bool ok)
 {
-  while (Serial.available())
+  if ( ok )
   {
-    Serial.read();
+    cmdslots.add(serialframer, c);
+  }
+  else
+  {
+    cmdslots.abandon(serialframer);
   }
 }
 
-void serialEvent()
+#ifdef BLUETOOTH
+// called from the software UART interrupt with each byte from the bt adapter
+void btrx(char c, bool ok)
 {
-  // : starts the command, # ends the command, do not store these in the command buffer
-  // read the command until the terminating # character
-  while (Serial.available() && !eoc)
+  if ( ok )
   {
-    char inChar = (char) Serial.read();
-    // add to string
-    line[idx++] = inChar;
-    if (idx >= MAXCOMMAND)
-    {
-      idx = MAXCOMMAND - 1;
-    }
-    if (inChar == '#')
-    {
-      eoc = 1;
-      idx = 0;
-      queue.push(String(line));
-      eoc = 0;
-      memset( line, 0, MAXCOMMAND);
-    }
+    cmdslots.add(btframer, c);
+  }
+  else
+  {
+    cmdslots.abandon(btframer);
   }
 }
+#endif
 
 // read the toggle switches and return which one is ON
 int readtoggleswitches(int pinNum)
@@ -1073,49 +1807,80 @@ int readtoggleswitches(int pinNum)
   }
 }
 
-#ifdef DHTXX
-void updatedhtsensor()
+// a reading after the health checks, then filtered
+// only a new good reading goes into the filter, and the first one after the sensor failed
+// starts the filter again, so it never takes in a held value or the 0 from before any reading
+// while the reading is held the last filter output is returned, so a spike the median would
+// have dropped is not held, once the sensor has failed the caller uses its fallback anyway
+template<uint8_t TAPS>
+float filteredreading(SensorHealth &health, MedianIIR<TAPS> &filter, bool ok, float value)
 {
-  // Read the humidity and temperature from DHTxx sensor
-  dhterrorflag = false;
-  if ( MYSENSOR == DHT11 )
-  {
-    dhtchk = mydht.read11( DHTDATA );
-  }
-  else if ( MYSENSOR == DHT21 )
+  bool wasfailed = health.failed();
+  float checked = health.update(ok, value);
+  uint8_t state = health.state();
+  if ( state == HEALTH_FAILED )
   {
-    dhtchk = mydht.read21( DHTDATA );
+    return checked;
   }
-  else if ( MYSENSOR == DHT22 )
+  if ( state == HEALTH_HOLD )
   {
-    dhtchk = mydht.read22( DHTDATA );
+    return filter.value();
   }
-  else if ( MYSENSOR == DHT33 )
+  if ( wasfailed )
   {
-    dhtchk = mydht.read33( DHTDATA );
+    filter.reset();
   }
-  else
+  return filter.update(checked);
+}
+
+#ifdef DHTXX
+// DHTDATA is pin 4, PD4, so its edges come in on pin change interrupt 2
+ISR(PCINT2_vect)
+{
+  if ( (PIND & _BV(DHTDATA)) == 0 )     // only falling edges are timed
   {
-    dhtchk = -3;                     // error - undefined sensor type
+    mydht.edge();
   }
+}
 
-  if ( dhtchk == DHTLIB_OK )            // sensor is ok, so this is the main program now
+// send the start signal, the reading is collected by the next updatedhtsensor()
+void startdhtsensor()
+{
+  mysensor::start();
+}
+
+// move the reading along, ends the DHT11 start signal, runs every pass
+void dhttask()
+{
+  mydht.update();
+}
+
+void updatedhtsensor()
+{
+  // Read the humidity and temperature from DHTxx sensor
+  dhterrorflag = false;
+  dhtchk = mydht.collect();             // reading started by the last call, captured in the background
+
+  // a bad read keeps the last good values for a few reads before the sensor is failed
+  bool dhtok = (dhtchk == DHTLIB_OK);
+  hval = filteredreading(humidityhealth, humidityfilter, dhtok, mydht.humidity);   // read the humidity
+  tval = filteredreading(ambienthealth, ambientfilter, dhtok, mydht.temperature) + dewconfig.ATBias;  // Read the ambient temperature and add any calibration bias offset
+  if ( (ambienthealth.failed() == false) && (humidityhealth.failed() == false) )   // sensor is ok, so this is the main program now
   {
-    hval = mydht.humidity;              // read the humidity
-    tval = mydht.temperature + dewconfig.ATBias;  // Read the ambient temperature and add any calibration bias offset
     dew_point = calc_dewpoint(tval, hval);        //calculate dew point
   }
   else
   {
     dhterrorflag = true;                // do nothing as cannot read sensor
 #ifdef LCDDISPLAY
-    lcd.clear();
-    lcd.print("DHTxx error");
+    lcdframe.clear();
+    lcdframe.print(F("DHTxx error"));
 #endif
 #ifdef OLEDDISPLAY
+    OLEDRenderLine = myoled.displayRows();   // stop any page being sent so the message stays up
     myoled.clear();
     myoled.InverseCharOn();
-    myoled.println("DHTXX ERROR");
+    myoled.println(F("DHTXX ERROR"));
     myoled.InverseCharOff();
 #endif
   }
@@ -1123,59 +1888,209 @@ void updatedhtsensor()
 #endif
 
 #ifdef HTU21DXX
-void read_htu21d_sensor()
+// start the temperature measurement, htutask() collects it and then measures humidity
+void starthtusensor()
 {
-  tval = htu21d.readTemperature();      // Read the ambient temperature
-  if ( (tval == 998) || (tval == 999 ))
-  {
-    tval_error = true;
-  }
-  else
+  htu21d.triggerTemperature();
+  htustate = HTU_TEMPERATURE;
+}
+
+// collect the HTU21D measurements when they are ready and calc dew_point, runs every pass
+void htutask()
+{
+  if ( htustate == HTU_TEMPERATURE )
   {
-    tval_error = false;                 // and tval = valid
+    float t = htu21d.collectTemperature();   // 997=not ready yet, 998=timeout, 999=crc invalid
+    if ( t == HTU21D_NOTREADY )
+    {
+      return;
+    }
+    // a bad read keeps the last good value for a few reads before the sensor is failed
     // add any calibration bias offset to ambient temperature
     // be careful - affects calculation below, offset for ATBIAS should not be necessary for HTU21D sensor
-    tval = tval + dewconfig.ATBias;
+    tval = filteredreading(ambienthealth, ambientfilter, (t != 998) && (t != 999), t) + dewconfig.ATBias;
+    tval_error = ambienthealth.failed();
+    htu21d.triggerHumidity();
+    htustate = HTU_HUMIDITY;
   }
-
-  hval_raw = htu21d.readHumidity();     // read the humidity, 998=timeout, 999=crc invalid
-  if ( (hval_raw == 998) || (hval_raw == 999 ))
+  else if ( htustate == HTU_HUMIDITY )
   {
-    hval_error = true;
-  }
-  else
-  {
-    hval_error = false;                   // and hval = valid
-    hval_comp = hval_raw + (25 - tval) * TempCoefficient;    // now perform temperature compensation using coefficient
+    float h = htu21d.collectHumidity();      // 997=not ready yet, 998=timeout, 999=crc invalid
+    if ( h == HTU21D_NOTREADY )
+    {
+      return;
+    }
+    hval_raw = filteredreading(humidityhealth, humidityfilter, (h != 998) && (h != 999), h);
+    hval_error = humidityhealth.failed();
+    if ( hval_error == false )
+    {
+      hval_comp = hval_raw + (25 - tval) * TempCoefficient;    // now perform temperature compensation using coefficient
+    }
+
+    if ( (hval_error == false) && (tval_error == false))
+    {
+      dew_point = calc_dewpoint(tval, hval_comp);    // calculate dew point only if both ambient temp and humidity are valid readings
+      dp_error = false;
+    }
+    else
+    {
+      dp_error = true;                    // cannot calculate dewpoint if humidity or ambient temp is invalid
+    }
+    htustate = HTU_IDLE;
   }
+}
 
-  if ( (hval_error == false) && (tval_error == false))
+#ifdef HTUADAPTIVE
+// 8 bit humidity is about 0.2C of dew point, fine while every channel is well clear of it
+// go back to full resolution when one gets close or there is no valid dew point
+// only call when htustate is HTU_IDLE, the sensor does not answer while measuring
+void adapthtu21dresolution()
+{
+  byte resolution = myHTU21DResolution;
+  if ( dp_error == true )
   {
-    dew_point = calc_dewpoint(tval, hval_comp);    // calculate dew point only if both ambient temp and humidity are valid readings
-    dp_error = false;
+    resolution = rh12t14;
   }
   else
   {
-    dp_error = true;                      // cannot calculate dewpoint if humidity or ambient temp is invalid
+    float margin = 100.0;               // closest channel to the dew point
+    if ( tprobe1 == 1 )
+    {
+      margin = min(margin, ch1tempval - dew_point);
+    }
+    if ( tprobe2 == 1 )
+    {
+      margin = min(margin, ch2tempval - dew_point);
+    }
+    if ( tprobe3 == 1 )
+    {
+      margin = min(margin, ch3tempval - dew_point);
+    }
+    margin = margin - dewconfig.offsetval;
+    if ( margin > HTUFASTMARGIN )
+    {
+      resolution = rh8t12;
+    }
+    else if ( margin < HTUPRECISEMARGIN )
+    {
+      resolution = rh12t14;
+    }
+  }
+  if ( resolution != myHTU21DResolution )
+  {
+    htu21d.setResolution(resolution);
+    myHTU21DResolution = resolution;
   }
 }
 #endif
+#endif
+
+// CH3DEW is a timer 2 output, with BLUETOOTH the software UART has timer 2 and pulses it instead
+// value is 0-255 as for analogWrite()
+void setch3dew(int value)
+{
+#ifdef BLUETOOTH
+  softuart.setpwm( CH3DEW, value );
+#else
+  analogWrite( CH3DEW, value );
+#endif
+}
 
-// Request temp readings for ch1-ch3
+// Request temp readings for ch1-ch3 and the board, on every bus with a probe in use
+// returns straight away, probetask() reads the results when the conversion is done
 void RequestTemperatures()
 {
-  if ( tprobe1 == 1 )
+  probes.request();
+}
+
+// read one probe scratchpad per tick so a read of many probes is never one long burst
+// 1-Wire holds interrupts off for up to 65us at a time, more than half a bluetooth bit, and a
+// scratchpad read is the longest run of them so it waits for a quiet tick, but only for
+// PROBEMAXSKIPS ticks, so a steady bluetooth stream cannot hold the readings off until they fail
+void probetask()
+{
+#ifdef BLUETOOTH
+  if ( softuart.busy() && (probeskips < PROBEMAXSKIPS) )
   {
-    sensor1.requestTemperatures();
+    probeskips++;
+    return;
   }
-  if ( tprobe2 == 1 )
+  probeskips = 0;
+#endif
+  probes.update();
+}
+
+#ifdef PROBEADAPTIVE
+// resolution for a channel from how far it is above the dew point, 9 bits well clear of it,
+// 12 bits close to it and TEMP_PRECISION in between, bits is the resolution it has now
+uint8_t probebits(float margin, uint8_t bits)
+{
+  if ( (margin > PROBEFARMARGIN) || ((bits == 9) && (margin > (PROBEFARMARGIN - PROBEHYSTERESIS))) )
   {
-    sensor2.requestTemperatures();
+    return 9;
   }
-  if ( tprobe4 == 1 )                   // board temp - used to control fan
+  if ( (margin < PROBENEARMARGIN) || ((bits == 12) && (margin < (PROBENEARMARGIN + PROBEHYSTERESIS))) )
+  {
+    return 12;
+  }
+  return TEMP_PRECISION;
+}
+
+// set the resolution of the ch1-ch3 probes and the sensor period from the last readings
+// only slow down when every channel with a probe is well clear and the dew point is known
+// call before RequestTemperatures(), the resolution cannot change during a conversion
+void adaptprobes()
+{
+#ifdef DHTXX
+  bool dpvalid = (dhterrorflag == false);
+#endif
+#ifdef HTU21DXX
+  bool dpvalid = (dp_error == false);
+#endif
+  float chtemp[3] = { ch1tempval, ch2tempval, ch3tempval };
+  int chprobe[3] = { tprobe1, tprobe2, tprobe3 };
+  bool slow = dpvalid;
+  for ( uint8_t ch = 0; ch < 3; ch++ )
   {
-    sensor4.requestTemperatures();
+    if ( chprobe[ch] == 0 )
+    {
+      continue;
+    }
+    uint8_t bits = TEMP_PRECISION;
+    if ( (ch == 2) && (dewconfig.shadowch != 4) )
+    {
+      bits = 9;                         // ch3 probe is not in use
+    }
+    else if ( dpvalid == true )
+    {
+      bits = probebits(chtemp[ch] - dew_point - dewconfig.offsetval, chbits[ch]);
+    }
+    if ( bits != 9 )
+    {
+      slow = false;
+    }
+    if ( bits != chbits[ch] )
+    {
+      probes.channelresolution(ch + 1, bits);
+      chbits[ch] = bits;
+    }
   }
+  scheduler.setperiod(sensortaskid, slow ? TEMPSLOWUPDATES : TEMPUPDATES);
+}
+#endif
+
+// a channel's probe reading after the health checks, the last good reading while it is bad
+float checkedtemp(uint8_t channel, SensorHealth &health)
+{
+  float t = probes.temperature(channel);
+  return health.update(t != DEVICE_DISCONNECTED_C, t);
+}
+
+// the checks of checkedtemp() and the filter of filteredreading(), for the dew channels
+float filteredtemp(uint8_t channel, SensorHealth &health, MedianIIR<PROBETAPS> &filter)
+{
+  float t = probes.temperature(channel);
+  return filteredreading(health, filter, t != DEVICE_DISCONNECTED_C, t);
 }
 
 // Read ch1-ch3 temperatures
@@ -1188,16 +2103,8 @@ void gettemps()
   }
   else                                  // there is a ch1 probe
   {
-    ch1tempval = sensor1.getTempCByIndex(0);        // get channel 1 temperature, always in celsius
+    ch1tempval = filteredtemp(1, ch1health, ch1filter);   // get channel 1 temperature, always in celsius
     ch1tempval = ch1tempval + dewconfig.ch1offset;  // adjust temperature values by the offset
-    if ( ch1override == 0 )             // override is off
-    {
-      ch1pwrval = getpwr( ch1tempval, dewconfig.TrackingState );
-    }
-    else
-    {
-      ch1pwrval = POWER_100;
-    }
   }
   if ( tprobe2 == 0 )                   // do nothing but return
   {
@@ -1206,16 +2113,8 @@ void gettemps()
   }
   else                                  // there is a ch2 probe
   {
-    ch2tempval = sensor2.getTempCByIndex(0);        // get channel 2 temperature, always in celsius
+    ch2tempval = filteredtemp(2, ch2health, ch2filter);   // get channel 2 temperature, always in celsius
     ch2tempval = ch2tempval + dewconfig.ch2offset;  // adjust temperature values by the offset
-    if ( ch2override == 0 )             // override is off
-    {
-      ch2pwrval = getpwr( ch2tempval, dewconfig.TrackingState );
-    }
-    else
-    {
-      ch2pwrval = POWER_100;
-    }
   }
 
   if ( tprobe4 == 0 )                               // do nothing but return
@@ -1224,7 +2123,75 @@ void gettemps()
   }
   else                                              // there is a board probe
   {
-    boardtemp = (int) sensor4.getTempCByIndex(0);   // get board temperature, always in celsius
+    boardtemp = (int) checkedtemp(4, boardhealth);  // get board temperature, always in celsius
+  }
+
+  // do not check ch3 as it can be used to shadow ch1/ch2 and not use a temp probe!!!!
+
+  // determine the ch3 tempval
+  switch ( dewconfig.shadowch )         // which mode is ch3?
+  {
+    case 0:                             // OFF
+      ch3tempval = 0.0;
+      break;
+    case 1:                             // shadow ch1
+      ch3tempval = ch1tempval;
+      break;
+    case 2:                             // shadow ch2
+      ch3tempval = ch2tempval;
+      break;
+    case 3:                             // manual setting
+      ch3tempval = 0.0;                 // ignore - use the setting of the slider from the main app
+      break;
+    case 4:                             // use temp probe3
+      if ( tprobe3 == 1 )               // could be 0 if user switches to ch3=temp probe3
+      {
+        ch3tempval = filteredtemp(3, ch3health, ch3filter);   // get temp, converted with the others
+        ch3tempval = ch3tempval + dewconfig.ch3offset;  // adjust by offset
+      }
+      else
+      {
+        ch3tempval = 0.0 + dewconfig.ch3offset;         // adjust by offset
+      }
+      break;
+  }  // end of switch
+}
+
+// power for a dew channel, FAILSAFEPOWER when its probe or the tracking has failed
+int channelpower( float channeltemp, SensorHealth &health )
+{
+  int trackmode = trackingmode();
+  if ( health.failed() || (trackmode == 0) )
+  {
+    return FAILSAFEPOWER;
+  }
+  return getpwr( channeltemp, trackmode );
+}
+
+// Work out the power for each channel and the fan from the latest readings
+void updatepower()
+{
+  if ( tprobe1 == 1 )
+  {
+    if ( ch1override == 0 )             // override is off
+    {
+      ch1pwrval = channelpower( ch1tempval, ch1health );
+    }
+    else
+    {
+      ch1pwrval = POWER_100;
+    }
+  }
+  if ( tprobe2 == 1 )
+  {
+    if ( ch2override == 0 )             // override is off
+    {
+      ch2pwrval = channelpower( ch2tempval, ch2health );
+    }
+    else
+    {
+      ch2pwrval = POWER_100;
+    }
   }
 
   if ( dewconfig.fantempon > 0 )                    // check if fan control is under fan temp sensor
@@ -1236,9 +2203,12 @@ void gettemps()
       digitalWrite( RLED, HIGH );
       digitalWrite( GLED, LOW );
       digitalWrite( BLED, LOW );
-      dewconfig.fanspeed = POWER_100;
-      updatefanmotor();
-      writeconfig();
+      if ( dewconfig.fanspeed != POWER_100 )
+      {
+        dewconfig.fanspeed = POWER_100;             // only saved when it changes, not every pass
+        updatefanmotor();
+        writeconfig();
+      }
     }
     else
     {
@@ -1263,42 +2233,6 @@ void gettemps()
     }
   }
 
-  // do not check ch3 as it can be used to shadow ch1/ch2 and not use a temp probe!!!!
-
-  // adjust ch1 and ch2 temperature values by the offset
-  ch1tempval = ch1tempval + dewconfig.ch1offset;
-  ch2tempval = ch2tempval + dewconfig.ch2offset;
-
-  // determine the ch3 tempval
-  switch ( dewconfig.shadowch )         // which mode is ch3?
-  {
-    case 0:                             // OFF
-      ch3tempval = 0.0;
-      break;
-    case 1:                             // shadow ch1
-      ch3tempval = ch1tempval;
-      break;
-    case 2:                             // shadow ch2
-      ch3tempval = ch2tempval;
-      break;
-    case 3:                             // manual setting
-      ch3tempval = 0.0;                 // ignore - use the setting of the slider from the main app
-      break;
-    case 4:                             // use temp probe3
-      if ( tprobe3 == 1 )               // could be 0 if user switches to ch3=temp probe3
-      {
-        sensor3.requestTemperatures();
-        delay(600 / (1 << (12 - TEMP_PRECISION)));      // should enough time to wait
-        ch3tempval = sensor3.getTempCByIndex(0);        // get temp
-        ch3tempval = ch3tempval + dewconfig.ch3offset;  // adjust by offset
-      }
-      else
-      {
-        ch3tempval = 0.0 + dewconfig.ch3offset;         // adjust by offset
-      }
-      break;
-  }  // end of switch
-
   // now think about ch3, both ch1/ch2 have been updated so we can use the latest values
   // get channel 3 powerval
   switch ( dewconfig.shadowch )         // which mode is ch3?
@@ -1318,7 +2252,7 @@ void gettemps()
     case 4:                             // use temp probe3
       if ( tprobe3 == 1 )
       {
-        ch3pwrval = getpwr( ch3tempval, dewconfig.TrackingState );  // get pwr setting
+        ch3pwrval = channelpower( ch3tempval, ch3health );  // get pwr setting
       }
       else
       {
@@ -1329,7 +2263,7 @@ void gettemps()
 
   analogWrite( CH1DEW, ch1pwrval * 2.54 );         // set the PWM value to be 0-254
   analogWrite( CH2DEW, ch2pwrval * 2.54 );
-  analogWrite( CH3DEW, ch3pwrval * 2.54 );
+  setch3dew( ch3pwrval * 2.54 );
 
   ch1oldtempval = ch1tempval;                       // remember last reading
   ch2oldtempval = ch2tempval;
@@ -1355,28 +2289,28 @@ void display1()
   String tempStr;
   float TempF;                          // used to hold conversion of temperatures to Fahrenheit
 
-  myoled.print("AMBIENT : ");           // ambient air temperature
+  oledslice.print(F("AMBIENT : "));        // ambient air temperature
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
 #ifdef HTU21DXX
     if ( tval_error == true )
 #endif
-      myoled.println(dashstr);
+      oledslice.println(FPSTR(dashstr));
     else
     {
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        myoled.println(tval, 2);
+        oledslice.println(tval, 2);
       }
       else
       {
         TempF = (tval * 1.8) + 32;      // assume its Fahrenheit then
-        myoled.println(TempF, 2);
+        oledslice.println(TempF, 2);
       }
     }
 
-  myoled.print("HUMIDITY: ");           // humdity
+  oledslice.print(F("HUMIDITY: "));        // humdity
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -1384,19 +2318,19 @@ void display1()
     if ( hval_error == true )
 #endif
     {
-      myoled.println(dashstr);
+      oledslice.println(FPSTR(dashstr));
     }
     else
     {
 #ifdef DHTXX
-      myoled.println(hval);
+      oledslice.println(hval, 0);
 #endif
 #ifdef HTU21DXX
-      myoled.println(hval_comp, 2);
+      oledslice.println(hval_comp, 2);
 #endif
     }
 
-  myoled.print("DEWPOINT: ");           // dewpoint
+  oledslice.print(F("DEWPOINT: "));        // dewpoint
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -1404,61 +2338,61 @@ void display1()
     if ( dp_error == true )
 #endif
     {
-      myoled.println(dashstr);
+      oledslice.println(FPSTR(dashstr));
     }
     else
     {
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        myoled.println(dew_point, 2);
+        oledslice.println(dew_point, 2);
       }
       else
       {
 
         TempF = (dew_point * 1.8) + 32; // assume its Fahrenheit then
-        myoled.println(TempF, 2);
+        oledslice.println(TempF, 2);
       }
     }
 
-  myoled.print("CH1 TEMP: ");           // temperature probe 1 and power
+  oledslice.print(F("CH1 TEMP: "));        // temperature probe 1 and power
   if ( tprobe1 != 1 )
   {
-    myoled.println(dashstr);
+    oledslice.println(FPSTR(dashstr));
   }
   else
   {
     if ( dewconfig.DisplayMode == CELSIUS )
     {
-      myoled.println(ch1tempval, 2);
+      oledslice.println(ch1tempval, 2);
     }
     else
     {
       TempF = (ch1tempval * 1.8) + 32;  // assume its Fahrenheit then
-      myoled.println(TempF, 2);
+      oledslice.println(TempF, 2);
     }
   }
-  myoled.print("CH1 PWR : ");
-  myoled.println( ch1pwrval );
+  oledslice.print(F("CH1 PWR : "));
+  oledslice.println( ch1pwrval );
 
-  myoled.print("CH1 OFF : ");           // ch1 offset
-  myoled.println(dewconfig.ch1offset, 2);
+  oledslice.print(F("CH1 OFF : "));        // ch1 offset
+  oledslice.println(dewconfig.ch1offset, 2);
 
-  myoled.print("TRACKING: ");           // tracking mode, (A)mbient or (D)ew point or (M)id point
+  oledslice.print(F("TRACKING: "));        // tracking mode, (A)mbient or (D)ew point or (M)id point
   if ( dewconfig.TrackingState == AMBIENT )
   {
-    myoled.println(astr);
+    oledslice.println(astr);
   }
   else if ( dewconfig.TrackingState == DEWPOINT )
   {
-    myoled.println(dstr);
+    oledslice.println(dstr);
   }
   else if ( dewconfig.TrackingState == HALFWAY )
   {
-    myoled.println(mstr);
+    oledslice.println(mstr);
   }
 
-  myoled.print("AT BIAS : ");           // print ATBias
-  myoled.println( dewconfig.ATBias );
+  oledslice.print(F("AT BIAS : "));        // print ATBias
+  oledslice.println( dewconfig.ATBias );
 
   DisplayPage = 2;
 }
@@ -1479,95 +2413,95 @@ void display2()
   String tempStr;
   float TempF;                          // used to hold conversion of temperatures to Fahrenheit
 
-  myoled.print("CH2 TEMP: ");           // temperature probe 2 and power
+  oledslice.print(F("CH2 TEMP: "));        // temperature probe 2 and power
   if ( tprobe2 != 1 )
   {
-    myoled.println(dashstr);
+    oledslice.println(FPSTR(dashstr));
   }
   else
   {
     if ( dewconfig.DisplayMode == CELSIUS )
     {
-      myoled.println(ch2tempval, 2);
+      oledslice.println(ch2tempval, 2);
     }
     else
     {
       TempF = (ch2tempval * 1.8) + 32;  // assume its Fahrenheit then
-      myoled.println(TempF, 2);
+      oledslice.println(TempF, 2);
     }
   }
 
-  myoled.print("CH2 PWR : ");
-  myoled.println( ch2pwrval );
+  oledslice.print(F("CH2 PWR : "));
+  oledslice.println( ch2pwrval );
 
-  myoled.print("CH2 OFF : ");           // ch2 offset
-  myoled.println(dewconfig.ch2offset, 2);
+  oledslice.print(F("CH2 OFF : "));        // ch2 offset
+  oledslice.println(dewconfig.ch2offset, 2);
 
-  myoled.print("CH3 TEMP: ");           // probe3 temperature and power
+  oledslice.print(F("CH3 TEMP: "));        // probe3 temperature and power
   switch ( dewconfig.shadowch )
   {
     case 0:                             // none
-      myoled.println(dashstr);
+      oledslice.println(FPSTR(dashstr));
       break;
     case 1:                             // ch1
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        myoled.println(ch3tempval, 2);
+        oledslice.println(ch3tempval, 2);
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;  // assume its Fahrenheit then
-        myoled.println(TempF, 2);
+        oledslice.println(TempF, 2);
       }
       break;
     case 2:                             // ch2
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        myoled.println(ch3tempval, 2);
+        oledslice.println(ch3tempval, 2);
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;  // assume its Fahrenheit then
-        myoled.println(TempF, 2);
+        oledslice.println(TempF, 2);
       }
       break;
     case 3:                             // manual - ignore
-      myoled.println(dashstr);
+      oledslice.println(FPSTR(dashstr));
       break;
     case 4:                             // use probe3
       if ( dewconfig.DisplayMode == CELSIUS )
       {
         if ( dewconfig.DisplayMode == CELSIUS )
         {
-          myoled.println(ch3tempval, 2);
+          oledslice.println(ch3tempval, 2);
         }
         else
         {
           TempF = (ch3tempval * 1.8) + 32;  // assume its Fahrenheit then
-          myoled.println(TempF, 2);
+          oledslice.println(TempF, 2);
         }
       }
       break;
   }
 
-  myoled.print("CH3 PWR : ");
-  myoled.println( ch3pwrval );;
+  oledslice.print(F("CH3 PWR : "));
+  oledslice.println( ch3pwrval );;
 
-  myoled.print("CH3 OFF : ");           // ch3 offset
-  myoled.println(dewconfig.ch3offset, 2);
+  oledslice.print(F("CH3 OFF : "));        // ch3 offset
+  oledslice.println(dewconfig.ch3offset, 2);
 
-  myoled.print("CH3 MODE: ");
+  oledslice.print(F("CH3 MODE: "));
   switch ( dewconfig.shadowch )
   {
-    case 0: myoled.println(offmsgstr);
+    case 0: oledslice.println(offmsgstr);
       break;
-    case 1: myoled.println(ch1msgstr);
+    case 1: oledslice.println(ch1msgstr);
       break;
-    case 2: myoled.println(ch2msgstr);
+    case 2: oledslice.println(ch2msgstr);
       break;
-    case 3: myoled.println(manstr);
+    case 3: oledslice.println(manstr);
       break;
-    case 4: myoled.println(probestr);
+    case 4: oledslice.println(probestr);
       break;
   }
 
@@ -1584,39 +2518,39 @@ void display3()
     Temp Mode
   */
 
-  myoled.print("PCB TEMP : ");
-  myoled.println(boardtemp);
+  oledslice.print(F("PCB TEMP : "));
+  oledslice.println(boardtemp);
 
-  myoled.print("PCB ON  T: ");
-  myoled.println(dewconfig.fantempon);
+  oledslice.print(F("PCB ON  T: "));
+  oledslice.println(dewconfig.fantempon);
 
-  myoled.print("PCB OFF T: ");
-  myoled.println(dewconfig.fantempoff);
+  oledslice.print(F("PCB OFF T: "));
+  oledslice.println(dewconfig.fantempoff);
 
-  myoled.print("FAN SPEED: ");
+  oledslice.print(F("FAN SPEED: "));
   switch ( dewconfig.fanspeed )
   {
-    case 0: myoled.println(POWER_0);            // 0% = OFF
+    case 0: oledslice.println(POWER_0);         // 0% = OFF
       break;
     case 50:
-      myoled.println(POWER_50);                // 50%
+      oledslice.println(POWER_50);             // 50%
       break;
     case 75:
-      myoled.println(POWER_75);                // 75%
+      oledslice.println(POWER_75);             // 75%
       break;
     case 100:
-      myoled.println(POWER_100);                // 100%
+      oledslice.println(POWER_100);             // 100%
       break;
   }
 
-  myoled.print("TEMP MODE: ");
+  oledslice.print(F("TEMP MODE: "));
   if ( dewconfig.DisplayMode == CELSIUS )
   {
-    myoled.println(celstr);
+    oledslice.println(celstr);
   }
   else
   {
-    myoled.println(fstr);                   // assume its Fahrenheit then
+    oledslice.println(fstr);                // assume its Fahrenheit then
   }
 
   DisplayPage = 1;                          // set to display next page
@@ -1633,7 +2567,7 @@ void updatelcd1602display1()
     DP:       ATB:
   */
 
-  lcd.print(atstr);                     // AT: ambient air temperature
+  lcdframe.print(FPSTR(atstr));                // AT: ambient air temperature
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -1641,23 +2575,23 @@ void updatelcd1602display1()
     if ( tval_error == true )
 #endif
     {
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
     }
     else
     {
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(tval, 1);
+        lcdframe.print(tval, 1);
       }
       else
       {
         TempF = (tval * 1.8) + 32;      // assume its Fahrenheit then
-        lcd.print(TempF, 1);
+        lcdframe.print(TempF, 1);
       }
     }
 
-  lcd.setCursor( 8, 0 );
-  lcd.print(hustr);                     // HU: humdity
+  lcdframe.setCursor( 8, 0 );
+  lcdframe.print(FPSTR(hustr));                // HU: humdity
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -1665,20 +2599,20 @@ void updatelcd1602display1()
     if ( hval_error == true )
 #endif
     {
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
     }
     else
     {
 #ifdef DHTXX
-      lcd.print( hval );
+      lcdframe.print( hval, 0 );
 #endif
 #ifdef HTU21DXX
-      lcd.print(hval_comp, 0);
+      lcdframe.print(hval_comp, 0);
 #endif
     }
 
-  lcd.setCursor( 0, 1 );                // DP: dewpoint
-  lcd.print(dpstr);
+  lcdframe.setCursor( 0, 1 );           // DP: dewpoint
+  lcdframe.print(FPSTR(dpstr));
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -1686,25 +2620,25 @@ void updatelcd1602display1()
     if ( dp_error == true )
 #endif
     {
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
     }
     else
     {
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(dew_point, 1);        // dew point C
+        lcdframe.print(dew_point, 1);   // dew point C
       }
       else
       {
         TempF = (dew_point * 1.8) + 32; // assume its Fahrenheit then
-        lcd.print(TempF, 1);
+        lcdframe.print(TempF, 1);
       }
     }
 
   // line 1 right
-  lcd.setCursor( 8, 1 );
-  lcd.print(atbstr);
-  lcd.print(dewconfig.ATBias);
+  lcdframe.setCursor( 8, 1 );
+  lcdframe.print(FPSTR(atbstr));
+  lcdframe.print(dewconfig.ATBias);
 
   LCD1602Screen = 2;                    // set to display next page
 }
@@ -1719,49 +2653,49 @@ void updatelcd1602display2()
 
   // print ch1/ch2 temps, ch1/ch2 pwr to LCD
   // LCD1602 values are displayed as Integers
-  lcd.print(c1str);                     // C1: temperature probe 1
+  lcdframe.print(FPSTR(c1str));                // C1: temperature probe 1
   if ( tprobe1 == 1 )
   {
     if ( dewconfig.DisplayMode == CELSIUS )
     {
-      lcd.print(ch1tempval, 1);
+      lcdframe.print(ch1tempval, 1);
     }
     else
     {
       TempF = (ch1tempval * 1.8) + 32;  // assume its Fahrenheit then
-      lcd.print(TempF, 1);
+      lcdframe.print(TempF, 1);
     }
   }
   else
   {
-    lcd.print(dashstr);
+    lcdframe.print(FPSTR(dashstr));
   }
 
-  lcd.setCursor(8, 0);                  // P1: probe1 power
-  lcd.print(p1str);
-  lcd.print(ch1pwrval);
+  lcdframe.setCursor(8, 0);             // P1: probe1 power
+  lcdframe.print(FPSTR(p1str));
+  lcdframe.print(ch1pwrval);
 
-  lcd.setCursor(0, 1);                  // C2: probe2 temperature
-  lcd.print(c2str);
+  lcdframe.setCursor(0, 1);             // C2: probe2 temperature
+  lcdframe.print(FPSTR(c2str));
   if ( tprobe2 ==  1 )
   {
     if ( dewconfig.DisplayMode == CELSIUS )
     {
-      lcd.print(ch2tempval, 1);
+      lcdframe.print(ch2tempval, 1);
     }
     else
     {
       TempF = (ch2tempval * 1.8) + 32;  // assume its Fahrenheit then
-      lcd.print(TempF, 1);
+      lcdframe.print(TempF, 1);
     }
   }
   else
   {
-    lcd.print(dashstr);
+    lcdframe.print(FPSTR(dashstr));
   }
-  lcd.setCursor(8, 1);                  // P2: probe2 power
-  lcd.print(p2str);
-  lcd.print(ch2pwrval);
+  lcdframe.setCursor(8, 1);             // P2: probe2 power
+  lcdframe.print(FPSTR(p2str));
+  lcdframe.print(ch2pwrval);
 
   LCD1602Screen = 3;                    // set to display next page
 }
@@ -1776,74 +2710,74 @@ void updatelcd1602display3()
 
   // line0 Ch3 temp and Pwr  C3:xxx.x P3:xxx
   // line1 ch1offset, ch2offset, ch3offset
-  lcd.print(c3str);                     // C3: probe3
+  lcdframe.print(FPSTR(c3str));                // C3: probe3
   switch ( dewconfig.shadowch )
   {
     case 0:                             // none
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
       break;
     case 1:                             // ch1
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(ch3tempval, 1 );
+        lcdframe.print(ch3tempval, 1 );
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;
-        lcd.print(TempF);
+        lcdframe.print(TempF);
       }
       break;
     case 2:                             // ch2
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(ch3tempval, 1 );
+        lcdframe.print(ch3tempval, 1 );
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;
-        lcd.print(TempF, 1);
+        lcdframe.print(TempF, 1);
       }
       break;
     case 3:                             // manual - ignore
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
       break;
     case 4:                             // use probe3
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(ch3tempval, 1);
+        lcdframe.print(ch3tempval, 1);
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;
-        lcd.print(TempF, 1);
+        lcdframe.print(TempF, 1);
       }
       break;
   }
 
-  lcd.setCursor(8, 0);                  // P3: probe3 power
-  lcd.print(p3str);
-  lcd.print(ch3pwrval);
+  lcdframe.setCursor(8, 0);             // P3: probe3 power
+  lcdframe.print(FPSTR(p3str));
+  lcdframe.print(ch3pwrval);
 
   // print offsets for ch1-ch3
   // xx.xx xx.xx xx.xx
-  lcd.setCursor(0, 1);
+  lcdframe.setCursor(0, 1);
   if ( dewconfig.ch1offset > 0.0 )
   {
-    lcd.print(plusstr);
+    lcdframe.print(plusstr);
   }
-  lcd.print(dewconfig.ch1offset, 1);
-  lcd.setCursor(5, 1);
+  lcdframe.print(dewconfig.ch1offset, 1);
+  lcdframe.setCursor(5, 1);
   if ( dewconfig.ch2offset > 0.0 )
   {
-    lcd.print(plusstr);
+    lcdframe.print(plusstr);
   }
-  lcd.print(dewconfig.ch2offset, 1);
-  lcd.setCursor(10, 1);
+  lcdframe.print(dewconfig.ch2offset, 1);
+  lcdframe.setCursor(10, 1);
   if ( dewconfig.ch3offset > 0.0 )
   {
-    lcd.print(plusstr);
+    lcdframe.print(plusstr);
   }
-  lcd.print(dewconfig.ch3offset, 1);
+  lcdframe.print(dewconfig.ch3offset, 1);
   LCD1602Screen = 4;                    // set to display next page
 }
 
@@ -1856,32 +2790,32 @@ void updatelcd1602display4()
   */
 
   // line 0
-  lcd.print(tmstr);                     // TM: tracking mode, (A)mbient or (D)ew point or (M)id point
+  lcdframe.print(FPSTR(tmstr));                // TM: tracking mode, (A)mbient or (D)ew point or (M)id point
   if ( dewconfig.TrackingState == AMBIENT )
   {
-    lcd.print(astr);
+    lcdframe.print(astr);
   }
   else if ( dewconfig.TrackingState == DEWPOINT )
   {
-    lcd.print(dstr);
+    lcdframe.print(dstr);
   }
   else if ( dewconfig.TrackingState == HALFWAY )
   {
-    lcd.print(mstr);
+    lcdframe.print(mstr);
   }
 
-  lcd.setCursor(8, 0);                  // tracking mode offset
-  lcd.print(tmostr);
-  lcd.print(dewconfig.offsetval);
+  lcdframe.setCursor(8, 0);             // tracking mode offset
+  lcdframe.print(FPSTR(tmostr));
+  lcdframe.print(dewconfig.offsetval);
 
   // line 1
   // PCB Temp
-  lcd.setCursor(0, 1);
-  lcd.print(pcbtstr);
-  lcd.print(boardtemp);
-  lcd.setCursor(8, 1);
-  lcd.print(pcbsstr);
-  lcd.print(dewconfig.fantempon);
+  lcdframe.setCursor(0, 1);
+  lcdframe.print(FPSTR(pcbtstr));
+  lcdframe.print(boardtemp);
+  lcdframe.setCursor(8, 1);
+  lcdframe.print(FPSTR(pcbsstr));
+  lcdframe.print(dewconfig.fantempon);
 
   LCD1602Screen = 5;
 }
@@ -1895,47 +2829,47 @@ void updatelcd1602display5()
   */
 
   // line0
-  lcd.print(ch3mstr);                    // ch3 mode
+  lcdframe.print(FPSTR(ch3mstr));               // ch3 mode
   switch ( dewconfig.shadowch )
   {
-    case 0: lcd.print(offmsgstr);
+    case 0: lcdframe.print(offmsgstr);
       break;
-    case 1: lcd.print(c1str);
+    case 1: lcdframe.print(FPSTR(c1str));
       break;
-    case 2: lcd.print(c2str);
+    case 2: lcdframe.print(FPSTR(c2str));
       break;
-    case 3: lcd.print(manstr);
+    case 3: lcdframe.print(manstr);
       break;
-    case 4: lcd.print(probestr);
+    case 4: lcdframe.print(probestr);
       break;
   }
 
   // line 1
-  lcd.setCursor(0, 1);
-  lcd.print(fsstr);                       // FanMotor speed
+  lcdframe.setCursor(0, 1);
+  lcdframe.print(FPSTR(fsstr));                  // FanMotor speed
   switch ( dewconfig.fanspeed )
   {
-    case 0: lcd.print(str0);           // 0% = OFF
+    case 0: lcdframe.print(str0);           // 0% = OFF
       break;
     case 50:
-      lcd.print(str50);                 // 50%
+      lcdframe.print(str50);            // 50%
       break;
     case 75:
-      lcd.print(str75);                 // 75%
+      lcdframe.print(str75);            // 75%
       break;
     case 100:
-      lcd.print(str100);                 // 100%
+      lcdframe.print(str100);            // 100%
       break;
   }
 
-  lcd.setCursor(8, 1);
+  lcdframe.setCursor(8, 1);
   if ( dewconfig.DisplayMode == CELSIUS )
   {
-    lcd.print(celstr);
+    lcdframe.print(celstr);
   }
   else
   {
-    lcd.print(fstr);                   // assume its Fahrenheit then
+    lcdframe.print(fstr);              // assume its Fahrenheit then
   }
   LCD1602Screen = 1;
 }
@@ -1955,7 +2889,7 @@ void updatelcd1604display1()
   */
 
   // line 0
-  lcd.print(atstr);                     // AT: ambient air temperature
+  lcdframe.print(FPSTR(atstr));                // AT: ambient air temperature
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -1963,22 +2897,22 @@ void updatelcd1604display1()
     if ( tval_error == true )
 #endif
     {
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
     }
     else
     {
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(tval, 1);
+        lcdframe.print(tval, 1);
       }
       else
       {
         TempF = (tval * 1.8) + 32;      // assume its Fahrenheit then
-        lcd.print(TempF, 1);
+        lcdframe.print(TempF, 1);
       }
     }
-  lcd.setCursor( 8, 0 );
-  lcd.print(hustr);                     // HU: humdity
+  lcdframe.setCursor( 8, 0 );
+  lcdframe.print(FPSTR(hustr));                // HU: humdity
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -1986,21 +2920,21 @@ void updatelcd1604display1()
     if ( hval_error == true )
 #endif
     {
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
     }
     else
     {
 #ifdef DHTXX
-      lcd.print( hval );
+      lcdframe.print( hval, 0 );
 #endif
 #ifdef HTU21DXX
-      lcd.print(hval_comp, 0);
+      lcdframe.print(hval_comp, 0);
 #endif
     }
 
   // line 1
-  lcd.setCursor( 0, 1 );                // DP: dewpoint
-  lcd.print(dpstr);
+  lcdframe.setCursor( 0, 1 );           // DP: dewpoint
+  lcdframe.print(FPSTR(dpstr));
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -2008,71 +2942,71 @@ void updatelcd1604display1()
     if ( dp_error == true )
 #endif
     {
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
     }
     else
     {
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(dew_point, 1);        // dew point C
+        lcdframe.print(dew_point, 1);   // dew point C
       }
       else
       {
         TempF = (dew_point * 1.8) + 32; // assume its Fahrenheit then
-        lcd.print(TempF, 1);
+        lcdframe.print(TempF, 1);
       }
     }
 
-  lcd.setCursor( 8, 1 );
-  lcd.print(atbstr);
-  lcd.print(dewconfig.ATBias);
+  lcdframe.setCursor( 8, 1 );
+  lcdframe.print(FPSTR(atbstr));
+  lcdframe.print(dewconfig.ATBias);
 
   // line 2
-  lcd.setCursor(0, 2);
-  lcd.print(c1str);                     // C1: temperature probe 1
+  lcdframe.setCursor(0, 2);
+  lcdframe.print(FPSTR(c1str));                // C1: temperature probe 1
   if ( tprobe1 == 1 )
   {
     if ( dewconfig.DisplayMode == CELSIUS )
     {
-      lcd.print(ch1tempval, 1);
+      lcdframe.print(ch1tempval, 1);
     }
     else
     {
       TempF = (ch1tempval * 1.8) + 32;  // assume its Fahrenheit then
-      lcd.print(TempF, 1);
+      lcdframe.print(TempF, 1);
     }
   }
   else
   {
-    lcd.print(dashstr);
+    lcdframe.print(FPSTR(dashstr));
   }
 
-  lcd.setCursor(8, 2);                  // P1: probe1 power
-  lcd.print(p1str4);
-  lcd.print(ch1pwrval);
+  lcdframe.setCursor(8, 2);             // P1: probe1 power
+  lcdframe.print(FPSTR(p1str4));
+  lcdframe.print(ch1pwrval);
 
   // line 3
-  lcd.setCursor(0, 3);                  // C2: probe2 temperature
-  lcd.print(c2str);
+  lcdframe.setCursor(0, 3);             // C2: probe2 temperature
+  lcdframe.print(FPSTR(c2str));
   if ( tprobe2 ==  1 )
   {
     if ( dewconfig.DisplayMode == CELSIUS )
     {
-      lcd.print(ch2tempval, 1);
+      lcdframe.print(ch2tempval, 1);
     }
     else
     {
       TempF = (ch2tempval * 1.8) + 32;  // assume its Fahrenheit then
-      lcd.print(TempF, 1);
+      lcdframe.print(TempF, 1);
     }
   }
   else
   {
-    lcd.print(dashstr);
+    lcdframe.print(FPSTR(dashstr));
   }
-  lcd.setCursor(8, 3);                  // P2: probe2 power
-  lcd.print(p2str4);
-  lcd.print(ch2pwrval);
+  lcdframe.setCursor(8, 3);             // P2: probe2 power
+  lcdframe.print(FPSTR(p2str4));
+  lcdframe.print(ch2pwrval);
 
 
   LCD1604Screen = 2;                    // set to display next page
@@ -2093,122 +3027,122 @@ void updatelcd1604display2()
   // xx.xx xx.xx xx.xx
   if ( dewconfig.ch1offset > 0.0 )
   {
-    lcd.print(plusstr);
+    lcdframe.print(plusstr);
   }
-  lcd.print(dewconfig.ch1offset, 1);
-  lcd.setCursor(5, 0);
+  lcdframe.print(dewconfig.ch1offset, 1);
+  lcdframe.setCursor(5, 0);
   if ( dewconfig.ch2offset > 0.0 )
   {
-    lcd.print(plusstr);
+    lcdframe.print(plusstr);
   }
-  lcd.print(dewconfig.ch2offset, 1);
-  lcd.setCursor(10, 0);
+  lcdframe.print(dewconfig.ch2offset, 1);
+  lcdframe.setCursor(10, 0);
   if ( dewconfig.ch3offset > 0.0 )
   {
-    lcd.print(plusstr);
+    lcdframe.print(plusstr);
   }
-  lcd.print(dewconfig.ch3offset, 1);
+  lcdframe.print(dewconfig.ch3offset, 1);
 
-  lcd.setCursor(0, 1);
-  lcd.print(c3str);                     // C3: probe3
+  lcdframe.setCursor(0, 1);
+  lcdframe.print(FPSTR(c3str));                // C3: probe3
   switch ( dewconfig.shadowch )
   {
     case 0:                             // none
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
       break;
     case 1:                             // ch1
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(ch3tempval, 1 );
+        lcdframe.print(ch3tempval, 1 );
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;
-        lcd.print(TempF);
+        lcdframe.print(TempF);
       }
       break;
     case 2:                             // ch2
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(ch3tempval, 1 );
+        lcdframe.print(ch3tempval, 1 );
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;
-        lcd.print(TempF, 1);
+        lcdframe.print(TempF, 1);
       }
       break;
     case 3:                             // manual - ignore
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
       break;
     case 4:                             // use probe3
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(ch3tempval, 1);
+        lcdframe.print(ch3tempval, 1);
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;
-        lcd.print(TempF, 1);
+        lcdframe.print(TempF, 1);
       }
       break;
   }
 
-  lcd.setCursor(9, 1);                  // P3: probe3 power
-  lcd.print(p3str);
-  lcd.print(ch3pwrval);
+  lcdframe.setCursor(9, 1);             // P3: probe3 power
+  lcdframe.print(FPSTR(p3str));
+  lcdframe.print(ch3pwrval);
 
 
   // line2
-  lcd.setCursor(0, 2);
-  lcd.print(tmstr);                     // TM: tracking mode, (A)mbient or (D)ew point or (M)id point
+  lcdframe.setCursor(0, 2);
+  lcdframe.print(FPSTR(tmstr));                // TM: tracking mode, (A)mbient or (D)ew point or (M)id point
   if ( dewconfig.TrackingState == AMBIENT )
   {
-    lcd.print(astr);
+    lcdframe.print(astr);
   }
   else if ( dewconfig.TrackingState == DEWPOINT )
   {
-    lcd.print(dstr);
+    lcdframe.print(dstr);
   }
   else if ( dewconfig.TrackingState == HALFWAY )
   {
-    lcd.print(mstr);
+    lcdframe.print(mstr);
   }
 
-  lcd.setCursor(9, 2);                  // tracking mode offset
-  lcd.print(tmostr);
-  lcd.print(dewconfig.offsetval);
+  lcdframe.setCursor(9, 2);             // tracking mode offset
+  lcdframe.print(FPSTR(tmostr));
+  lcdframe.print(dewconfig.offsetval);
 
   // line3
-  lcd.setCursor(0, 3);
-  lcd.print(ch3mstr);                    // ch3 mode
+  lcdframe.setCursor(0, 3);
+  lcdframe.print(FPSTR(ch3mstr));               // ch3 mode
   switch ( dewconfig.shadowch )
   {
-    case 0: lcd.print(offmsgstr);
+    case 0: lcdframe.print(offmsgstr);
       break;
-    case 1: lcd.print(c1str);
+    case 1: lcdframe.print(FPSTR(c1str));
       break;
-    case 2: lcd.print(c2str);
+    case 2: lcdframe.print(FPSTR(c2str));
       break;
-    case 3: lcd.print(manstr);
+    case 3: lcdframe.print(manstr);
       break;
-    case 4: lcd.print(probestr);
+    case 4: lcdframe.print(probestr);
       break;
   }
-  lcd.setCursor(9, 3);
-  lcd.print(fsstr);                       // FanMotor speed
+  lcdframe.setCursor(9, 3);
+  lcdframe.print(FPSTR(fsstr));                  // FanMotor speed
   switch ( dewconfig.fanspeed )
   {
-    case 0: lcd.print(str0);           // 0% = OFF
+    case 0: lcdframe.print(str0);           // 0% = OFF
       break;
     case 50:
-      lcd.print(str50);                 // 50%
+      lcdframe.print(str50);            // 50%
       break;
     case 75:
-      lcd.print(str75);                 // 75%
+      lcdframe.print(str75);            // 75%
       break;
     case 100:
-      lcd.print(str100);                 // 100%
+      lcdframe.print(str100);            // 100%
       break;
   }
 
@@ -2223,14 +3157,14 @@ void updatelcd1604display3()
   */
 
   // line 0
-  lcd.print(pcbtstr);                   // pcb temp
-  lcd.print(boardtemp);
-  lcd.setCursor(8, 0);
-  lcd.print(pcbsstr);                   // pcb fan temp on
-  lcd.print(dewconfig.fantempon);
-  lcd.setCursor(0, 1);
-  lcd.print(pcbsstroff);                // pcb fan temp off
-  lcd.print(dewconfig.fantempoff);
+  lcdframe.print(FPSTR(pcbtstr));              // pcb temp
+  lcdframe.print(boardtemp);
+  lcdframe.setCursor(8, 0);
+  lcdframe.print(FPSTR(pcbsstr));              // pcb fan temp on
+  lcdframe.print(dewconfig.fantempon);
+  lcdframe.setCursor(0, 1);
+  lcdframe.print(FPSTR(pcbsstroff));           // pcb fan temp off
+  lcdframe.print(dewconfig.fantempoff);
 
   // line1
 
@@ -2253,7 +3187,7 @@ void updatelcd2004display1()
 
   // LCD2004 values are displayed to 2 decimal places
 
-  lcd.print(atstr1);                    // ambient temperature
+  lcdframe.print(FPSTR(atstr1));               // ambient temperature
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -2261,22 +3195,22 @@ void updatelcd2004display1()
     if ( tval_error == true )
 #endif
     {
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
     }
     else
     {
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(tval, 2);
+        lcdframe.print(tval, 2);
       }
       else
       {
         TempF = (tval * 1.8) + 32;
-        lcd.print(TempF, 2);
+        lcdframe.print(TempF, 2);
       }
     }
-  lcd.setCursor( 0, 1);                 // row 1
-  lcd.print(dpstr1);                    // dewpoint
+  lcdframe.setCursor( 0, 1);            // row 1
+  lcdframe.print(FPSTR(dpstr1));               // dewpoint
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -2284,22 +3218,22 @@ void updatelcd2004display1()
     if ( dp_error == true )
 #endif
     {
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
     }
     else
     {
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(dew_point, 2);        // dew point C
+        lcdframe.print(dew_point, 2);   // dew point C
       }
       else
       {
         TempF = (dew_point * 1.8) + 32;
-        lcd.print(TempF, 2);
+        lcdframe.print(TempF, 2);
       }
     }
-  lcd.setCursor( 0, 2 );
-  lcd.print(hustr1);                    // humdity
+  lcdframe.setCursor( 0, 2 );
+  lcdframe.print(FPSTR(hustr1));               // humdity
 #ifdef DHTXX
   if ( dhterrorflag )
 #endif
@@ -2307,22 +3241,22 @@ void updatelcd2004display1()
     if ( hval_error == true )
 #endif
     {
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
     }
     else
     {
 #ifdef DHTXX
-      lcd.print( hval );
+      lcdframe.print( hval, 0 );
 #endif
 #ifdef HTU21DXX
-      lcd.print(hval_comp, 2);
+      lcdframe.print(hval_comp, 2);
 #endif
     }
 
   // line 3
-  lcd.setCursor(0, 3);
-  lcd.print(atbiasstr1);                // ATBias
-  lcd.print(dewconfig.ATBias);
+  lcdframe.setCursor(0, 3);
+  lcdframe.print(FPSTR(atbiasstr1));           // ATBias
+  lcdframe.print(dewconfig.ATBias);
 
   LCD2004Screen = 2;
 }
@@ -2336,57 +3270,57 @@ void updatelcd2004display2()
     CH2 PWR = xxx
   */
 
-  lcd.print(ch1str);                    // ch1 temperature
-  lcd.print(tmpstr);
+  lcdframe.print(FPSTR(ch1str));               // ch1 temperature
+  lcdframe.print(FPSTR(tmpstr));
   if ( tprobe1 == 0 )
   {
-    lcd.print(dashstr);
+    lcdframe.print(FPSTR(dashstr));
   }
   else
   {
     if ( dewconfig.DisplayMode == CELSIUS )
     {
-      lcd.print(ch1tempval, 2 );
+      lcdframe.print(ch1tempval, 2 );
     }
     else
     {
       TempF = (ch1tempval * 1.8) + 32;
-      lcd.print(TempF, 2);
+      lcdframe.print(TempF, 2);
     }
   }
 
   // line 1
-  lcd.setCursor( 0 , 1 );               // next line
-  lcd.print(ch2str);                    // ch2 temperature
-  lcd.print(tmpstr);
+  lcdframe.setCursor( 0 , 1 );          // next line
+  lcdframe.print(FPSTR(ch2str));               // ch2 temperature
+  lcdframe.print(FPSTR(tmpstr));
   if ( tprobe2 == 0 )
   {
-    lcd.print(dashstr);
+    lcdframe.print(FPSTR(dashstr));
   }
   else
   {
     if ( dewconfig.DisplayMode == CELSIUS )
     {
-      lcd.print(ch2tempval, 2 );
+      lcdframe.print(ch2tempval, 2 );
     }
     else
     {
       TempF = (ch2tempval * 1.8) + 32;
-      lcd.print(TempF, 2);
+      lcdframe.print(TempF, 2);
     }
   }
 
   // line 2
-  lcd.setCursor( 0 , 2 );               // next line
-  lcd.print(ch1str);                    // ch1 power
-  lcd.print(pwrstr);
-  lcd.print(ch1pwrval);
+  lcdframe.setCursor( 0 , 2 );          // next line
+  lcdframe.print(FPSTR(ch1str));               // ch1 power
+  lcdframe.print(FPSTR(pwrstr));
+  lcdframe.print(ch1pwrval);
 
   // line 3
-  lcd.setCursor( 0 , 3 );               // ch2 power
-  lcd.print(ch2str);
-  lcd.print(pwrstr);
-  lcd.print(ch2pwrval);
+  lcdframe.setCursor( 0 , 3 );          // ch2 power
+  lcdframe.print(FPSTR(ch2str));
+  lcdframe.print(FPSTR(pwrstr));
+  lcdframe.print(ch2pwrval);
 
   LCD2004Screen = 3;
 }
@@ -2401,77 +3335,77 @@ void updatelcd2004display3()
   */
 
   // line 0
-  lcd.print(ch3str);                    // ch3 temperature
-  lcd.print(tmpstr);
+  lcdframe.print(FPSTR(ch3str));               // ch3 temperature
+  lcdframe.print(FPSTR(tmpstr));
   switch ( dewconfig.shadowch )
   {
     case 0:                             // none
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
       break;
     case 1:                             // ch1
     case 2:                             // ch2
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(ch3tempval, 2 );
-        lcd.print(celstr);
+        lcdframe.print(ch3tempval, 2 );
+        lcdframe.print(celstr);
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;
-        lcd.print(TempF, 2);
-        lcd.print(fstr);
+        lcdframe.print(TempF, 2);
+        lcdframe.print(fstr);
       }
       break;
     case 3:                             // manual - ignore
-      lcd.print(dashstr);
+      lcdframe.print(FPSTR(dashstr));
       break;
     case 4:                             // use probe3
       if ( dewconfig.DisplayMode == CELSIUS )
       {
-        lcd.print(ch3tempval, 2 );
-        lcd.print(celstr);
+        lcdframe.print(ch3tempval, 2 );
+        lcdframe.print(celstr);
       }
       else
       {
         TempF = (ch3tempval * 1.8) + 32;
-        lcd.print(TempF, 2);
-        lcd.print(fstr);
+        lcdframe.print(TempF, 2);
+        lcdframe.print(fstr);
       }
       break;
   }
   // line 1
-  lcd.setCursor( 0 , 1 );
-  lcd.print(ch3str);                    // ch3 power
-  lcd.print(pwrstr);
-  lcd.print(ch3pwrval);
+  lcdframe.setCursor( 0 , 1 );
+  lcdframe.print(FPSTR(ch3str));               // ch3 power
+  lcdframe.print(FPSTR(pwrstr));
+  lcdframe.print(ch3pwrval);
 
   // line 2
-  lcd.setCursor( 0 , 2 );
-  lcd.print(ch3str);                    // ch3 mode
-  lcd.print(modestr);
+  lcdframe.setCursor( 0 , 2 );
+  lcdframe.print(FPSTR(ch3str));               // ch3 mode
+  lcdframe.print(FPSTR(modestr));
   switch ( dewconfig.shadowch )
   {
-    case 0: lcd.print(offstr);
+    case 0: lcdframe.print(FPSTR(offstr));
       break;
-    case 1: lcd.print(ch1str);
+    case 1: lcdframe.print(FPSTR(ch1str));
       break;
-    case 2: lcd.print(ch2str);
+    case 2: lcdframe.print(FPSTR(ch2str));
       break;
-    case 3: lcd.print(manstr);
+    case 3: lcdframe.print(manstr);
       break;
-    case 4: lcd.print(probestr);
+    case 4: lcdframe.print(probestr);
       break;
   }
 
   // line 3
-  lcd.setCursor( 0 , 3 );
-  lcd.print(tmstr1);                    // tracking mode, (A)mbient or (D)ew point
+  lcdframe.setCursor( 0 , 3 );
+  lcdframe.print(FPSTR(tmstr1));               // tracking mode, (A)mbient or (D)ew point
   if ( dewconfig.TrackingState == AMBIENT )
-    lcd.print("AMBIENT");
+    lcdframe.print(F("AMBIENT"));
   else if ( dewconfig.TrackingState == DEWPOINT )
-    lcd.print("DEWPOINT");
+    lcdframe.print(F("DEWPOINT"));
   else if ( dewconfig.TrackingState == HALFWAY )
-    lcd.print("MIDPOINT");
+    lcdframe.print(F("MIDPOINT"));
 
   LCD2004Screen = 4;
 }
@@ -2486,37 +3420,37 @@ void updatelcd2004display4()
   */
 
   // line 0
-  lcd.setCursor(0, 0);
-  lcd.print(ch1str);                    // ch1 offset
-  lcd.print(offstr);
+  lcdframe.setCursor(0, 0);
+  lcdframe.print(FPSTR(ch1str));               // ch1 offset
+  lcdframe.print(FPSTR(offstr));
   if (dewconfig.ch1offset > 0 )
-    lcd.print("+");
-  lcd.print(dewconfig.ch1offset);
+    lcdframe.print(F("+"));
+  lcdframe.print(dewconfig.ch1offset);
 
   // line 1
-  lcd.setCursor(0, 1);
-  lcd.print(ch2str);                    // ch2 offset
-  lcd.print(offstr);
+  lcdframe.setCursor(0, 1);
+  lcdframe.print(FPSTR(ch2str));               // ch2 offset
+  lcdframe.print(FPSTR(offstr));
   if (dewconfig.ch2offset > 0 )
   {
-    lcd.print(plusstr);
+    lcdframe.print(plusstr);
   }
-  lcd.print(dewconfig.ch2offset);
+  lcdframe.print(dewconfig.ch2offset);
 
   // line 2
-  lcd.setCursor(0, 2);
-  lcd.print(ch3str);                    // ch3 offset
-  lcd.print(offstr);
+  lcdframe.setCursor(0, 2);
+  lcdframe.print(FPSTR(ch3str));               // ch3 offset
+  lcdframe.print(FPSTR(offstr));
   if (dewconfig.ch3offset > 0 )
   {
-    lcd.print(plusstr);
+    lcdframe.print(plusstr);
   }
-  lcd.print(dewconfig.ch3offset);
+  lcdframe.print(dewconfig.ch3offset);
 
   // line 3
-  lcd.setCursor(0, 3);
-  lcd.print(tmoffsetstr);
-  lcd.print(dewconfig.offsetval);
+  lcdframe.setCursor(0, 3);
+  lcdframe.print(FPSTR(tmoffsetstr));
+  lcdframe.print(dewconfig.offsetval);
 
   LCD2004Screen = 5;
 }
@@ -2530,29 +3464,29 @@ void updatelcd2004display5()
   */
 
   // line 0
-  lcd.print(pcbtempstr);
-  lcd.print(boardtemp);
+  lcdframe.print(FPSTR(pcbtempstr));
+  lcdframe.print(boardtemp);
 
   // line 1
-  lcd.setCursor(0 , 1);
-  lcd.print(pcbtempsetpointstr);
-  lcd.print(dewconfig.fantempon);
+  lcdframe.setCursor(0 , 1);
+  lcdframe.print(FPSTR(pcbtempsetpointstr));
+  lcdframe.print(dewconfig.fantempon);
 
   // line 2
-  lcd.setCursor( 0, 2 );
-  lcd.print(fanspeedstr);                 // FanMotor speed
+  lcdframe.setCursor( 0, 2 );
+  lcdframe.print(FPSTR(fanspeedstr));            // FanMotor speed
   switch ( dewconfig.fanspeed )
   {
-    case 0: lcd.print(str0);              // 0% = OFF
+    case 0: lcdframe.print(str0);              // 0% = OFF
       break;
     case 50:
-      lcd.print(str50);                   // 50%
+      lcdframe.print(str50);              // 50%
       break;
     case 75:
-      lcd.print(str75);                   // 75%
+      lcdframe.print(str75);              // 75%
       break;
     case 100:
-      lcd.print(str100);                  // 100%
+      lcdframe.print(str100);             // 100%
       break;
   }
 
@@ -2561,17 +3495,245 @@ void updatelcd2004display5()
 #endif
 #endif
 
+// --------------------------------------------------------
+// TASKS - called by the scheduler from loop(), see setup() for the periods
+
+// check for serial and bluetooth commands, runs every pass
+void commstask()
+{
+  uint8_t port;
+  uint16_t seq;
+  while ( cmdslots.busy(port, seq) )    // tell the sender about commands dropped with no free slot
+  {
+    replyport = port;
+    if ( seq != SEQ_NONE )
+    {
+      replytag(seq);
+    }
+    replychar('!');
+    replyend();
+  }
+
+  if ( cmdslots.count() >= 1 )          // check for serial command
+  {
+    STATSTART();
+    processcmd();
+    STATEND(STATPROCESSCMD);
+  }
+}
+
+// check toggle switch for override
+void switchtask()
+{
+  if ( computeroverride == 0 )                        // if the windows app does not have control
+  {
+    PBVal = readtoggleswitches(TOGGLESWPIN);          // read the toggle switches
+    switch ( PBVal )                                  // then use the state of the switches
+    {
+      case 0:                         // toggle sw1 and sw2 are OFF
+        if ( ch1override == 1)
+        {
+          ch1override = 0;
+        }
+        if ( ch2override == 1)
+        {
+          ch2override = 0;
+        }
+        break;
+      case 1:                         // toggle sw1 is ON and 2 is off
+        if ( tprobe1 == 1 )           // if there is a probe1
+        {
+          ch1override = 1;            // set ch1 to override
+          ch1pwrval = POWER_100;            // set pwm pwr to 100%
+        }
+        if ( ch2override == 1)
+        {
+          ch2override = 0;
+        }        break;
+      case 2:                         // toggle sw2 is ON and SW1 is OFF
+        if ( tprobe2 == 1 )           // if there is a probe1
+        {
+          ch2override = 1;            // set ch2 to override
+          ch2pwrval = POWER_100;            // set pwm pwr to 100%
+        }
+        if ( ch1override == 1)
+        {
+          ch1override = 0;
+        }
+        break;
+      case 3:                         // toggle sw1 and sw2 are ON
+        if ( tprobe1 == 1 )           // if there is a probe1
+        {
+          ch1override = 1;            // set ch1 to override
+          ch1pwrval = POWER_100;            // set pwm pwr to 100%
+        }
+        if ( tprobe2 == 1 )           // if there is a probe2
+        {
+          ch2override = 1;            // set ch2 to override
+          ch2pwrval = POWER_100;            // set pwm pwr to 100%
+        }
+        break;
+    }
+  }
+  else                                // computeroverride is true so ignore reading switches as its under control of windows app
+  {
+    // do nothing
+  }
+}
+
+// alternate between starting a conversion on the probes and reading the results
+void sensortask()
+{
+  if ( temprefresh == false )
+  {
+    // trigger reads of temperature probes
+#ifdef PROBEADAPTIVE
+    adaptprobes();
+#endif
+    RequestTemperatures();
+#ifdef DHTXX
+    startdhtsensor();                   // captured in the background, collected with the probes
+#endif
+#ifdef HTU21DXX
+    if ( htustate == HTU_IDLE )
+    {
+#ifdef HTUADAPTIVE
+      adapthtu21dresolution();          // before the trigger, the sensor ignores commands while measuring
+#endif
+      starthtusensor();                 // collected by htutask() in the background
+    }
+#endif
+    temprefresh = true;
+  }
+  else
+  {
+    // read the temperature probes
+    STATSTART();
+    gettemps();
+    STATEND(STATGETTEMPS);
+    STATSTART();
+#ifdef DHTXX
+    updatedhtsensor();                  // trigger humidity and ambient and calc dew_point
+#endif
+    STATEND(STATSENSOR);
+    temprefresh = false;
+    scheduler.trigger(controltaskid);   // new readings, work out the power levels straight away
+  }
+}
+
+// set the dew strap and fan outputs from the latest readings
+void controltask()
+{
+  updatepower();
+}
+
+// draw the next display page, the flush task sends it
+void displaytask()
+{
+  scheduler.setperiod(displaytaskid, dewconfig.displaytime);  // follow any change to the page time
+  if ( displayenabled == false )        // if display is off then do not print values
+  {
+    return;
+  }
+#ifdef LCDDISPLAY
+  lcdframe.clear();
+#ifdef LCD1602
+  STATPAGESTART(LCD1602Screen);
+  switch ( LCD1602Screen )
+  {
+    case 1: updatelcd1602display1();
+      break;
+    case 2: updatelcd1602display2();
+      break;
+    case 3: updatelcd1602display3();
+      break;
+    case 4: updatelcd1602display4();
+      break;
+    case 5: updatelcd1602display5();
+      break;
+  }
+  STATPAGEEND();
+#endif
+#ifdef LCD1604
+  STATPAGESTART(LCD1604Screen);
+  switch ( LCD1604Screen )
+  {
+    case 1: updatelcd1604display1();
+      break;
+    case 2: updatelcd1604display2();
+      break;
+    case 3: updatelcd1604display3();
+      break;
+  }
+  STATPAGEEND();
+#endif
+#ifdef LCD2004
+  STATPAGESTART(LCD2004Screen);
+  switch ( LCD2004Screen )
+  {
+    case 1: updatelcd2004display1();
+      break;
+    case 2: updatelcd2004display2();
+      break;
+    case 3: updatelcd2004display3();
+      break;
+    case 4: updatelcd2004display4();
+      break;
+    case 5: updatelcd2004display5();
+      break;
+  }
+  STATPAGEEND();
+#endif
+#endif
+#ifdef OLEDDISPLAY
+  OLEDRenderPage = DisplayPage;         // start sending this page from the top line
+  OLEDRenderLine = 0;
+#endif
+}
+
+// send a slice of the page each pass so a full redraw does not hold up serial commands
+void flushtask()
+{
+  if ( displayenabled == false )
+  {
+    return;
+  }
+#ifdef LCDDISPLAY
+  lcdframe.update(LCDCELLSPERPASS);     // send up to LCDCELLSPERPASS of the cells that changed
+#endif
+#ifdef OLEDDISPLAY
+  if ( OLEDRenderLine < myoled.displayRows() )
+  {
+    oledslice.begin(OLEDRenderLine);    // run the page, only this line reaches the display
+    STATPAGESTART(OLEDRenderPage);
+    switch ( OLEDRenderPage )
+    {
+      case 1: display1();
+        break;
+      case 2: display2();
+        break;
+      case 3: display3();
+        break;
+    }
+    STATPAGEEND();
+    oledslice.end();
+    OLEDRenderLine++;
+  }
+#endif
+}
+
+// --------------------------------------------------------
 void setup()
 {
   int datasize;                         // will hold size of the struct dewconfig in bytes, 18 bytes
   int nlocations;                       // number of storage locations available in EEPROM
   bool found;                           // did we find any stored values?
 
-  Serial.begin(SERIALPORTSPEED);        // start serial port now
-  clearSerialPort();                    // clear any garbage from serial buffer
+  cmdslots.begin(serialframer, PORT_SERIAL);
+  uart.begin(SERIALPORTSPEED, serialrx);  // start serial port now, commands are received from here on
 #ifdef BLUETOOTH
-  btSerial.begin(BTPORTSPEED);          // do not change!!!!!!!!!!!!
-  clearbtPort();
+  cmdslots.begin(btframer, PORT_BLUETOOTH);
+  softuart.begin(BTPORTSPEED, BTTX, BTRX, btrx);  // do not change!!!!!!!!!!!! receive on the adapter's TX pin
 #endif
 
   displayenabled = true;
@@ -2588,10 +3750,11 @@ void setup()
   lcd.begin(20, 4);
 #endif
   lcd.setBacklight(HIGH);
-  lcd.print("myDewCtrlrPro3");
-  lcd.setCursor( 0, 1 );                // col, row
-  lcd.print("(c)RBB ");
-  lcd.print(ver);
+  lcdframe.print(F("myDewCtrlrPro3"));
+  lcdframe.setCursor( 0, 1 );           // col, row
+  lcdframe.print(F("(c)RBB "));
+  lcdframe.print(FPSTR(ver));
+  lcdframe.update();
 #ifdef LCD1602
   LCD1602Screen = 1;                    // always start at page 1 for any display
 #endif
@@ -2615,12 +3778,13 @@ void setup()
   myoled.Display_Rotate(0);             // portrait, not rotated
   myoled.Display_Bright();
   DisplayPage = 1;                      // start at page1
+  OLEDRenderLine = myoled.displayRows();  // nothing to send until the first page is due
   // print startup screen
   // The screen size is 128 x 64, so using characters at 6x8 this gives 21chars across and 8 lines down
-  myoled.println(programName1);
-  myoled.println(ver);
+  myoled.println(FPSTR(programName1));
+  myoled.println(FPSTR(ver));
   myoled.InverseCharOn();
-  myoled.println(programAuthor);
+  myoled.println(FPSTR(programAuthor));
   myoled.InverseCharOff();
 #endif
 
@@ -2632,26 +3796,20 @@ void setup()
   pinMode( GLED, OUTPUT );
   pinMode( BLED, OUTPUT );
 
-  eoc = 0;
-  idx = 0;
-  memset(line, 0, MAXCOMMAND);
-#ifdef BLUETOOTH
-  bteoc = 0;
-  btidx = 0;
-  memset(btline, 0, MAXCOMMAND);
-#endif
 
   currentaddr = 0;                      // start at 0 if not found later
   found = false;
   writenow = false;
-  datasize = sizeof( dewconfig );      // 26 bytes
-  nlocations = EEPROMSIZE / datasize;  // for AT328P = 1024 / datasize = 39 locations
+  datasize = sizeof( dewconfig );      // 86 bytes
+  nlocations = CONFIGAREA / datasize;  // for AT328P = 643 / datasize = 7 locations below the profiles
 
-  for (int lp1 = 0; lp1 < nlocations; lp1++ )
+  // look as far as the 11 locations used before the profiles, so an older config is kept
+  // the profiles may have overwritten those, so whatever is found there must be in range too
+  for (int lp1 = 0; lp1 < (EEPROMSIZE / datasize); lp1++ )
   {
     int addr = lp1 * datasize;
     EEPROM_readAnything( addr, dewconfig );
-    if ( dewconfig.validdata == 99 )    // check to see if the data is valid
+    if ( (dewconfig.validdata == EEPROMVALID) && ((lp1 < nlocations) || configvalid(dewconfig)) )   // check to see if the data is valid
     {
       currentaddr = addr;               // data was erased so write some default values
       found = true;
@@ -2676,18 +3834,28 @@ void setup()
     {
       currentaddr = 0;
     }
-    dewconfig.validdata = 99;
+    dewconfig.validdata = EEPROMVALID;
     writeconfig();                      // update values in EEPROM
   }
   else
   {
     seteepromdefaults();                // set defaults because not found
   }
-
-  temptimer = displaytimer = millis();  // start time interval for display and temperature updates
+  profile_t profile;
+  if ( readprofile(EEPROM.read(BOOTPROFILEADDR), profile) )
+  {
+    dewconfig = profile.config;         // start with the boot profile instead of the last config
+    writeconfig();
+  }
 
 #ifdef DHTXX
   dhterrorflag = false;
+  *digitalPinToPCMSK(DHTDATA) |= _BV(digitalPinToPCMSKbit(DHTDATA));   // edges on DHTDATA raise PCINT2
+  PCICR |= _BV(digitalPinToPCICRbit(DHTDATA));
+  startdhtsensor();
+  while ( mydht.update() )              // wait for the first reading, about 25ms at most
+  {
+  }
   updatedhtsensor();                    // trigger humidity and ambient and calc dew_point
 #endif
 
@@ -2701,83 +3869,47 @@ void setup()
   hval_error = false;                   // if there was an error reading humidity value then set to true
   tval_error = false;                   // if there was an error reading temperature value then set to true
   dp_error = false;                     // if humidity or ambient temp is invalid then cannot calculate dew point
-  read_htu21d_sensor();                 // trigger humidity and ambient and calc dew_point
-#endif
-
-  // start temperature sensors DS18B20
-  tprobe1 = 0;                                // set probe indicators OFF
-  tprobe2 = 0;
-  tprobe3 = 0;
-  tprobe4 = 0;
-  sensor1.begin();                            // start the temperature sensor1
-  sensor1.getDeviceCount();                   // should return 1 if probe connected
-  for (int i = 0; i < MAXPROBES; i++)         // look for probes
+  starthtusensor();                     // trigger humidity and ambient and calc dew_point
+  while ( htustate != HTU_IDLE )        // wait for the first reading, about 70ms at full resolution
   {
-    if (sensor1.getAddress(tpAddress, i))     // Search the wire for address
-    {
-      // found?
-      tprobe1 = 1;                            // there is a probe1
-      sensor1.setResolution(tpAddress, TEMP_PRECISION);
-      // set the resolution for that probe to 9bit 0.5degC
-      // as the accuracy is only +-0.5degC anyway
-    }
+    htutask();
   }
+#endif
 
-  // repeat for channel 2 probe
+  // start temperature sensors DS18B20, every device on a bus reports to that bus's channel
+  // unless the config binds its ROM code to another channel
+  sensor1.begin();
+  probes.addbus( &sensor1, 1 );
   sensor2.begin();
-  sensor2.getDeviceCount();                   // should return 1 if probe connected
-  for (int i = 0; i < MAXPROBES; i++)
-  {
-    if (sensor2.getAddress(tpAddress, i))     // Search the wire for address
-    {
-      tprobe2 = 1;                            // there is a probe2
-      sensor2.setResolution(tpAddress, TEMP_PRECISION);
-    }
-  }
-
-  // repeat for channel 3 probe
+  probes.addbus( &sensor2, 2 );
   sensor3.begin();
-  sensor3.getDeviceCount();                   // should return 1 if probe connected
-  for (int i = 0; i < MAXPROBES; i++)
-  {
-    if (sensor3.getAddress(tpAddress, i))     // Search the wire for address
-    {
-      tprobe3 = 1;                            // there is a probe3
-      sensor3.setResolution(tpAddress, TEMP_PRECISION);
-    }
-  }
-
-  // repeat for channel 4 board temp sensor
+  probes.addbus( &sensor3, 3 );
   pcbfanon = false;
-  sensor4.begin();
-  sensor4.getDeviceCount();                   // should return 1 if probe connected
-  for (int i = 0; i < MAXPROBES; i++)
-  {
-    if (sensor4.getAddress(tpAddress, i))     // Search the wire for address
-    {
-      tprobe4 = 1;                            // there is a probe4
-      sensor4.setResolution(tpAddress, TEMP_PRECISION);
-    }
-  }
+  sensor4.begin();                            // channel 4 board temp sensor
+  probes.addbus( &sensor4, 4 );
+  probes.setresolution(TEMP_PRECISION);       // accuracy is only +-0.5degC anyway
+  applyprobemap();
 
-  int nprobes = tprobe1 + tprobe2 + tprobe3;
 #ifdef LCDDISPLAY
-  lcd.clear();
-  lcd.setCursor( 0, 0 );
-  lcd.print(probesequals);                    // print the number of temperature probes
-  lcd.print(nprobes);
-  lcd.setCursor( 0, 1 );
-  lcd.print(PCBprobeequalsstr);
+  int nprobes = tprobe1 + tprobe2 + tprobe3;
+  lcdframe.clear();
+  lcdframe.setCursor( 0, 0 );
+  lcdframe.print(probesequals);               // print the number of temperature probes
+  lcdframe.print(nprobes);
+  lcdframe.setCursor( 0, 1 );
+  lcdframe.print(PCBprobeequalsstr);
   if ( tprobe4 == 1 )
   {
-    lcd.print(yesstr);
+    lcdframe.print(yesstr);
   }
   else
   {
-    lcd.print(nostr);
+    lcdframe.print(nostr);
   }
+  lcdframe.update();
 #endif
 #ifdef OLEDDISPLAY
+  int nprobes = tprobe1 + tprobe2 + tprobe3;
   myoled.print(probesequals);
   myoled.println(nprobes);
   myoled.print(PCBprobeequalsstr);
@@ -2806,9 +3938,7 @@ void setup()
   ch3oldtempval = ch3tempval;
   analogWrite( CH1DEW, ch1pwrval );     // set dewchannel1, 2, 3 off
   analogWrite( CH2DEW, ch2pwrval );
-  analogWrite( CH3DEW, ch3pwrval );
-
-  buttonLastChecked = millis() + BUTTONDELAY; // force a check this cycle
+  setch3dew( ch3pwrval );
 
   if ( (dewconfig.fanspeed > 100) || (dewconfig.fanspeed < 0) )
   {
@@ -2822,180 +3952,47 @@ void setup()
   }
 
   RequestTemperatures();
-  delay(1000);
+  while ( probes.update() )             // wait for the conversion and read every probe
+  {
+  }
   gettemps();                        // read ch1/ch2/ch3 temperatures
+  updatepower();
 
   // this bit of code takes care of the fact that first run this variable has not been set yet
   dewconfig.displaytime = (dewconfig.displaytime < MINPAGETIME) ? MINPAGETIME : dewconfig.displaytime;
   dewconfig.displaytime = (dewconfig.displaytime > MAXPAGETIME) ? MAXPAGETIME : dewconfig.displaytime;
   writeconfig();
-}
-
-// --------------------------------------------------------
-void loop()
-{
-#ifdef BLUETOOTH
-  btSerialEvent();                      // check for command from bt adapter
-#endif
-
-  if ( queue.count() >= 1 )             // check for serial command
-  {
-    processcmd();
-  }
-
-  // check toggle switch for override
-  buttonchecktime = millis();
-  // make sure 1s has elapsed since last read
-  if ( ((buttonchecktime - buttonLastChecked) > BUTTONDELAY) || (buttonchecktime < buttonLastChecked) )
-  {
-    if ( computeroverride == 0 )                        // if the windows app does not have control
-    {
-      PBVal = readtoggleswitches(TOGGLESWPIN);          // read the toggle switches
-      buttonLastChecked = buttonchecktime;              // reset the lastChecked value
-      switch ( PBVal )                                  // then use the state of the switches
-      {
-        case 0:                         // toggle sw1 and sw2 are OFF
-          if ( ch1override == 1)
-          {
-            ch1override = 0;
-          }
-          if ( ch2override == 1)
-          {
-            ch2override = 0;
-          }
-          break;
-        case 1:                         // toggle sw1 is ON and 2 is off
-          if ( tprobe1 == 1 )           // if there is a probe1
-          {
-            ch1override = 1;            // set ch1 to override
-            ch1pwrval = POWER_100;            // set pwm pwr to 100%
-          }
-          if ( ch2override == 1)
-          {
-            ch2override = 0;
-          }        break;
-        case 2:                         // toggle sw2 is ON and SW1 is OFF
-          if ( tprobe2 == 1 )           // if there is a probe1
-          {
-            ch2override = 1;            // set ch2 to override
-            ch2pwrval = POWER_100;            // set pwm pwr to 100%
-          }
-          if ( ch1override == 1)
-          {
-            ch1override = 0;
-          }
-          break;
-        case 3:                         // toggle sw1 and sw2 are ON
-          if ( tprobe1 == 1 )           // if there is a probe1
-          {
-            ch1override = 1;            // set ch1 to override
-            ch1pwrval = POWER_100;            // set pwm pwr to 100%
-          }
-          if ( tprobe2 == 1 )           // if there is a probe2
-          {
-            ch2override = 1;            // set ch2 to override
-            ch2pwrval = POWER_100;            // set pwm pwr to 100%
-          }
-          break;
-      }
-    }
-    else                                // computeroverride is true so ignore reading switches as its under control of windows app
-    {
-      // do nothing
-    }
-  }
-  // end of toggle-switch code
 
-  // handle the temperatures
-  currenttime = millis();
-  if ( ((currenttime - temptimer) > TEMPUPDATES) || (currenttime < temptimer) )
-  {
-    temptimer = currenttime;     // update the timestamp
-    if ( temprefresh == false )
-    {
-      // trigger reads of temperature probes
-      RequestTemperatures();
-      temprefresh = true;
-    }
-    else
-    {
-      // read the temperature probes
-      gettemps();
+  // tasks run in this order when more than one is due, (task, period ms, deadline ms)
+  uint8_t switchtaskid;
+  scheduler.add( commstask, 0, 0 );                                       // every pass
+  switchtaskid = scheduler.add( switchtask, BUTTONDELAY, 100 );
+  sensortaskid = scheduler.add( sensortask, TEMPUPDATES, 50 );
+  scheduler.add( probetask, PROBETICK, 10 );
 #ifdef DHTXX
-      updatedhtsensor();                  // trigger humidity and ambient and calc dew_point
+  scheduler.add( dhttask, 0, 0 );                                         // every pass
 #endif
 #ifdef HTU21DXX
-      read_htu21d_sensor();               // read humidity and ambient and calc dew_point
-#endif
-      temprefresh = false;
-    }
-  }
+  scheduler.add( htutask, 0, 0 );                                         // every pass
+#endif
+  controltaskid = scheduler.add( controltask, TEMPUPDATES * 2, 50 );      // also triggered by each sensor read
+  displaytaskid = scheduler.add( displaytask, dewconfig.displaytime, 100 );
+  scheduler.add( flushtask, 0, 0 );                                       // every pass
+  scheduler.add( imagetask, 0, 0 );                                       // every pass, after everything else
+  scheduler.begin();                    // start time interval for display and temperature updates
+  scheduler.trigger(switchtaskid);      // check the switches on the first pass
+}
 
-  // Handle the lcd display
-  currenttime = millis();
-  if ( displayenabled == true )        // if display is off then do not print values
-  {
-    if ( ((currenttime - displaytimer) > dewconfig.displaytime) || (currenttime < displaytimer) )
-    {
-      displaytimer = currenttime;     // update the timestamp
-#ifdef LCDDISPLAY
-      lcd.clear();
-#ifdef LCD1602
-      switch ( LCD1602Screen )
-      {
-        case 1: updatelcd1602display1();
-          break;
-        case 2: updatelcd1602display2();
-          break;
-        case 3: updatelcd1602display3();
-          break;
-        case 4: updatelcd1602display4();
-          break;
-        case 5: updatelcd1602display5();
-          break;
-      }
-#endif
-#ifdef LCD1604
-      switch ( LCD1604Screen )
-      {
-        case 1: updatelcd1604display1();
-          break;
-        case 2: updatelcd1604display2();
-          break;
-        case 3: updatelcd1604display3();
-          break;
-      }
-#endif
-#ifdef LCD2004
-      switch ( LCD2004Screen )
-      {
-        case 1: updatelcd2004display1();
-          break;
-        case 2: updatelcd2004display2();
-          break;
-        case 3: updatelcd2004display3();
-          break;
-        case 4: updatelcd2004display4();
-          break;
-        case 5: updatelcd2004display5();
-          break;
-      }
-#endif
+// --------------------------------------------------------
+void loop()
+{
+#ifdef LOOPSTATS
+  unsigned long loopstart = micros();
 #endif
-#ifdef OLEDDISPLAY
-      myoled.clear();
-      switch ( DisplayPage )
-      {
-        case 1: display1();
-          break;
-        case 2: display2();
-          break;
-        case 3: display3();
-          break;
-      }
+  scheduler.run();
+#ifdef LOOPSTATS
+  loopstats.looptime(micros() - loopstart);
 #endif
-    }
-  }
 }
 
 // FIRMWARE CODE END